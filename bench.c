@@ -0,0 +1,725 @@
+/**
+ * Rope Pulling Game - IPC Microbenchmarks
+ * Measures the latencies of the referee <-> player control and data paths
+ * and reports p50/p99/p999 per path, plus a JSON file for comparing runs
+ *
+ * Every path is one entry of the benches[] table; a new transport only
+ * needs a function that fills in its samples.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "constant.h"
+#include "config.h"
+#include "pipe.h"
+#include "shm.h"
+#include "loop.h"
+#include "game_rules.h"
+#include "ranking.h"
+#include "player_thread.h"
+#include "stats.h"
+#include "tick_kernel.h"
+#include "launch.h"
+
+#define DEFAULT_ITERS  10000
+#define MAX_RESULTS    64
+
+typedef struct {
+    char name[64];
+    int n;
+    long long *samples;   // ns, sorted once the bench is done
+} BenchResult;
+
+static int iters = DEFAULT_ITERS;
+static int bench_players = DEFAULT_NUM_TEAMS * DEFAULT_TEAM_SIZE;
+static BenchResult results[MAX_RESULTS];
+static int n_results = 0;
+
+/**
+ * Start a new result with room for n samples
+ */
+static BenchResult *new_result(const char *name, int n)
+{
+    if (n_results == MAX_RESULTS) {
+        fprintf(stderr, "too many bench results\n");
+        exit(1);
+    }
+    BenchResult *r = &results[n_results++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->n = 0;
+    r->samples = malloc(n * sizeof(long long));
+    if (!r->samples) {
+        perror("malloc failed");
+        exit(1);
+    }
+    return r;
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static long long percentile(const BenchResult *r, double p)
+{
+    int k = (int)(p * (r->n - 1) + 0.5);
+    return r->samples[k];
+}
+
+static double mean_of(const BenchResult *r)
+{
+    double sum = 0;
+    for (int i = 0; i < r->n; i++)
+        sum += r->samples[i];
+    return r->n ? sum / r->n : 0.0;
+}
+
+/**
+ * Block until fd has n bytes for us
+ */
+static int read_full(int fd, void *buf, int n)
+{
+    int got = 0;
+    while (got < n) {
+        int k = read_effort(fd, (char *)buf + got, n - got);
+        if (k <= 0)
+            return -1;
+        got += k;
+    }
+    return 0;
+}
+
+/* ---- Pipe data path: write_effort()/read_effort() per message type ---- */
+
+static void bench_pipe_message(const char *type, int size)
+{
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe failed");
+        exit(1);
+    }
+    char *buf = calloc(1, size);
+    char name[64];
+    snprintf(name, sizeof(name), "write_effort %s (%dB)", type, size);
+    BenchResult *w = new_result(name, iters);
+    snprintf(name, sizeof(name), "read_effort %s (%dB)", type, size);
+    BenchResult *r = new_result(name, iters);
+
+    // Messages above PIPE_BUF don't fit the pipe in one go, keep them apart
+    for (int i = 0; i < iters; i++) {
+        long long t0 = mono_ns();
+        int n = write_effort(fds[1], buf, size);
+        long long t1 = mono_ns();
+        int m = read_effort(fds[0], buf, size);
+        long long t2 = mono_ns();
+        if (n != size || m != size) {
+            fprintf(stderr, "short pipe transfer %d/%d of %d\n", n, m, size);
+            break;
+        }
+        w->samples[w->n++] = t1 - t0;
+        r->samples[r->n++] = t2 - t1;
+    }
+    free(buf);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void bench_pipe_messages(void)
+{
+    bench_pipe_message("TickRecord", sizeof(TickRecord));
+    bench_pipe_message("LocationMessage", sizeof(LocationMessage));
+    bench_pipe_message("GraphicsMessage 2x4", GRAPHICS_MSG_SIZE(2, 4));
+    bench_pipe_message("GraphicsMessage 2x64", GRAPHICS_MSG_SIZE(2, 64));
+}
+
+/* ---- Signal delivery: kill() to handler entry ---- */
+
+static int stamp_fd = -1;
+
+static void on_stamp(int sig)
+{
+    long long now = mono_ns();
+    write(stamp_fd, &now, sizeof(now));
+}
+
+static void bench_signal_handler(void)
+{
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe failed");
+        exit(1);
+    }
+
+    // Block the signal until the handler is in place, so none is lost
+    sigset_t mask, old;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIG_ENERGY_REQ);
+    sigprocmask(SIG_BLOCK, &mask, &old);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        stamp_fd = fds[1];
+        signal(SIG_ENERGY_REQ, on_stamp);
+        sigprocmask(SIG_SETMASK, &old, NULL);
+        long long ready = 0;
+        write(stamp_fd, &ready, sizeof(ready));
+        while (1)
+            pause();
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    close(fds[1]);
+
+    BenchResult *r = new_result("kill -> signal handler entry", iters);
+    long long stamp;
+    read_full(fds[0], &stamp, sizeof(stamp));   // child is ready
+    for (int i = 0; i < iters; i++) {
+        long long t0 = mono_ns();
+        kill(pid, SIG_ENERGY_REQ);
+        if (read_full(fds[0], &stamp, sizeof(stamp)) != 0)
+            break;
+        r->samples[r->n++] = stamp - t0;
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    close(fds[0]);
+}
+
+/* ---- Real ./player processes: the referee's control path ---- */
+
+typedef struct {
+    pid_t pid;
+    int effort_fd;   // read end
+    int loc_fd;      // write end
+} BenchPlayer;
+
+static SharedState *shared = NULL;
+static int shared_fd = -1;
+
+/**
+ * Spawn n ./player processes the way the referee does (pipe mode)
+ */
+static BenchPlayer *spawn_bench_players(int n, int team_size)
+{
+    shared = shm_create(n, &shared_fd);
+    if (!shared)
+        exit(1);
+    shared->tick_ns = 1000000000LL;
+    shared->ipc_mode = IPC_PIPE;
+    shared->team_size = team_size;
+
+    BenchPlayer *bp = calloc(n, sizeof(BenchPlayer));
+    for (int i = 0; i < n; i++) {
+        int ep[2], lp[2];
+        if (pipe(ep) == -1 || pipe(lp) == -1) {
+            perror("pipe failed");
+            exit(1);
+        }
+        for (int k = 0; k < 2; k++) {
+            fcntl(ep[k], F_SETFD, FD_CLOEXEC);
+            fcntl(lp[k], F_SETFD, FD_CLOEXEC);
+        }
+
+        PlayerLaunch pl = {
+            .magic = LAUNCH_MAGIC,
+            .size = sizeof(PlayerLaunch),
+            .id = i % team_size,
+            .team = i / team_size,
+            .energy = 50 + i,
+            .decay_rate = 1,
+            .params = { .energy_min = 0, .energy_max = 100, .decay_min = 1, .decay_max = 2,
+                        .recover_min = 1, .recover_max = 2 },
+        };
+        // Players log every location, keep them quiet
+        pid_t pid = launch_player("./player", &pl, ep[1], lp[0], shared_fd, -1, 1);
+        if (pid == -1)
+            exit(1);
+        close(ep[1]);
+        close(lp[0]);
+        bp[i].pid = pid;
+        bp[i].effort_fd = ep[0];
+        bp[i].loc_fd = lp[1];
+    }
+
+    // Let them install their signal handlers, then check they answer
+    usleep(100000);
+    for (int i = 0; i < n; i++) {
+        TickRecord er;
+        kill(bp[i].pid, SIG_ENERGY_REQ);
+        if (read_full(bp[i].effort_fd, &er, sizeof(er)) != 0) {
+            fprintf(stderr, "player %d did not answer\n", i);
+            exit(1);
+        }
+    }
+    return bp;
+}
+
+static void stop_bench_players(BenchPlayer *bp, int n)
+{
+    for (int i = 0; i < n; i++)
+        kill(bp[i].pid, SIG_TERMINATE);
+    for (int i = 0; i < n; i++) {
+        waitpid(bp[i].pid, NULL, 0);
+        close(bp[i].effort_fd);
+        close(bp[i].loc_fd);
+    }
+    free(bp);
+    munmap(shared, sizeof(SharedState) + n * sizeof(PlayerSlot));
+    close(shared_fd);
+}
+
+static void bench_energy_request(void)
+{
+    BenchPlayer *bp = spawn_bench_players(1, 1);
+    BenchResult *r = new_result("kill SIG_ENERGY_REQ -> state report read", iters);
+    for (int i = 0; i < iters; i++) {
+        TickRecord er;
+        long long t0 = mono_ns();
+        kill(bp[0].pid, SIG_ENERGY_REQ);
+        if (read_full(bp[0].effort_fd, &er, sizeof(er)) != 0)
+            break;
+        r->samples[r->n++] = mono_ns() - t0;
+    }
+    stop_bench_players(bp, 1);
+}
+
+/**
+ * assign_locations() end to end: request every energy, gather the replies,
+ * rank each team and send the locations
+ */
+static void bench_assign_locations(void)
+{
+    int team_size = DEFAULT_TEAM_SIZE;
+    int n = bench_players;
+    int teams = n / team_size;
+    BenchPlayer *bp = spawn_bench_players(n, team_size);
+    RankEntry *ranking = malloc(team_size * sizeof(RankEntry));
+    int *energy = malloc(n * sizeof(int));
+
+    char name[64];
+    snprintf(name, sizeof(name), "assign_locations (%d players)", n);
+    int rounds = iters / 10 > 0 ? iters / 10 : 1;
+    BenchResult *r = new_result(name, rounds);
+    for (int it = 0; it < rounds; it++) {
+        long long t0 = mono_ns();
+        for (int i = 0; i < n; i++)
+            kill(bp[i].pid, SIG_ENERGY_REQ);
+
+        // Replies in whatever order they are ready
+        struct pollfd *pfd = calloc(n, sizeof(struct pollfd));
+        int pending = n;
+        for (int i = 0; i < n; i++) {
+            pfd[i].fd = bp[i].effort_fd;
+            pfd[i].events = POLLIN;
+        }
+        while (pending > 0 && poll(pfd, n, 1000) > 0) {
+            for (int i = 0; i < n; i++) {
+                if (pfd[i].fd < 0 || !(pfd[i].revents & POLLIN))
+                    continue;
+                TickRecord er;
+                if (read_full(pfd[i].fd, &er, sizeof(er)) == 0)
+                    energy[i] = er.energy;
+                pfd[i].fd = -1;
+                pending--;
+            }
+        }
+        free(pfd);
+
+        for (int t = 0; t < teams; t++) {
+            for (int k = 0; k < team_size; k++) {
+                ranking[k].index = t * team_size + k;
+                ranking[k].energy = energy[t * team_size + k];
+            }
+            rank_by_energy(ranking, team_size);
+            for (int k = 0; k < team_size; k++) {
+                LocationMessage lm = { .player_id = ranking[k].index % team_size, .location = k };
+                write_effort(bp[ranking[k].index].loc_fd, &lm, sizeof(lm));
+                kill(bp[ranking[k].index].pid, SIG_SET_LOC);
+            }
+        }
+        r->samples[r->n++] = mono_ns() - t0;
+
+        // Let the players take their location before the next request
+        usleep(1000);
+    }
+    free(ranking);
+    free(energy);
+    stop_bench_players(bp, n);
+}
+
+/* ---- Shared-memory slots (ipc_mode shm) ---- */
+
+static void bench_shm_slot(void)
+{
+    int fd;
+    SharedState *ss = shm_create(2, &fd);
+    if (!ss)
+        exit(1);
+
+    // Ping-pong: we publish tick k in slot 0, the child echoes it in slot 1
+    pid_t pid = fork();
+    if (pid == 0) {
+        PlayerSlot ps;
+        PlayerData pd = {0};
+        int seen = 0;
+        for (;;) {
+            if (slot_read(&ss->slots[0], &ps) == 0 && ps.tick != seen) {
+                seen = ps.tick;
+                if (seen < 0)
+                    exit(0);
+                slot_publish(&ss->slots[1], &pd, 0, seen, 0, 0);
+            } else {
+                sched_yield();
+            }
+        }
+    }
+
+    BenchResult *pub = new_result("slot_publish", iters);
+    BenchResult *rt = new_result("shm slot round trip (publish -> echo seen)", iters);
+    PlayerData pd = {0};
+    PlayerSlot ps;
+    for (int i = 1; i <= iters; i++) {
+        long long t0 = mono_ns();
+        slot_publish(&ss->slots[0], &pd, 0, i, 0, 0);
+        long long t1 = mono_ns();
+        while (slot_read(&ss->slots[1], &ps) != 0 || ps.tick != i)
+            sched_yield();
+        pub->samples[pub->n++] = t1 - t0;
+        rt->samples[rt->n++] = mono_ns() - t0;
+    }
+    slot_publish(&ss->slots[0], &pd, 0, -1, 0, 0);
+    waitpid(pid, NULL, 0);
+
+    BenchResult *rd = new_result("slot_read", iters);
+    for (int i = 0; i < iters; i++) {
+        long long t0 = mono_ns();
+        slot_read(&ss->slots[1], &ps);
+        rd->samples[rd->n++] = mono_ns() - t0;
+    }
+    munmap(ss, sizeof(SharedState) + 2 * sizeof(PlayerSlot));
+    close(fd);
+}
+
+/* ---- Player threads (player_engine thread) ---- */
+
+static void bench_thread_request(void)
+{
+    int fd;
+    SharedState *ss = shm_create(1, &fd);
+    if (!ss)
+        exit(1);
+    ss->tick_ns = 1000000000LL;
+    ss->ipc_mode = IPC_PIPE;
+    ss->team_size = 1;
+
+    PlayerData pd = { .id = 0, .team = 0, .energy = 80, .decay_rate = 1 };
+    PlayerParams pp = { 0, 100, 1, 2, 1, 2 };
+
+    // The threads print what player processes print, keep them quiet
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+
+    int stats_fd;
+    StatsPage *sp = stats_create(1, 1, &stats_fd);
+    if (threads_start(&pd, 1, &pp, ss, sp->players, NULL) != 0)
+        exit(1);
+    BenchResult *r = new_result("thread SIG_ENERGY_REQ -> reply drained", iters);
+    struct pollfd pfd = { .fd = threads_fd(), .events = POLLIN };
+    for (int i = 0; i < iters; i++) {
+        ThreadReply tr;
+        long long t0 = mono_ns();
+        threads_send(0, SIG_ENERGY_REQ, 0);
+        while (threads_drain(&tr, 1) == 0)
+            poll(&pfd, 1, 1000);
+        r->samples[r->n++] = mono_ns() - t0;
+    }
+    threads_stop();
+    stats_finish(sp);
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    close(null_fd);
+    munmap(ss, sizeof(SharedState) + sizeof(PlayerSlot));
+    close(fd);
+}
+
+/* ---- Headless tick kernel: scalar vs. vector lanes ---- */
+
+static void lanes_seed(PlayerLanes *pl, int team_size)
+{
+    for (int i = 0; i < pl->n; i++) {
+        pl->energy[i] = 50 + i % 51;
+        pl->location[i] = i % team_size;
+    }
+}
+
+/**
+ * Time one tick of every player per kernel the CPU supports, and check
+ * that every kernel ends in exactly the state of the scalar one
+ */
+static void bench_tick_kernel(void)
+{
+    static const int counts[] = { 8, 64, 512, 4096, 32768 };
+    const PlayerParams pp = { 0, 100, 1, 7, 1, 3 };
+    int ticks = iters / 10 > 0 ? iters / 10 : 1;
+    int saved = tick_kernel_isa();
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        int n = counts[c], team_size = n / 2;
+        PlayerLanes ref, pl;
+        double scalar_p50 = 0;
+        if (lanes_init(&ref, n, 12345) != 0 || lanes_init(&pl, n, 12345) != 0) {
+            perror("lanes allocation failed");
+            exit(1);
+        }
+
+        for (int isa = KERNEL_SCALAR; isa <= KERNEL_AVX2; isa++) {
+            if (tick_kernel_use(isa) != 0)
+                continue;
+            PlayerLanes *l = isa == KERNEL_SCALAR ? &ref : &pl;
+            int sums[2] = {0, 0};
+            lanes_seed(l, team_size);
+
+            char name[64];
+            snprintf(name, sizeof(name), "tick_kernel %s (%d players)", tick_kernel_name(isa), n);
+            BenchResult *r = new_result(name, ticks);
+            for (int k = 0; k < ticks; k++) {
+                if (k % 50 == 0)
+                    lanes_reset_energy(l, &pp, k / 50 + 1);   // a new round now and then
+                long long t0 = mono_ns();
+                tick_kernel(l, &pp, k / 50 + 1, k % 50 + 1, 2, team_size, sums);
+                r->samples[r->n++] = mono_ns() - t0;
+            }
+
+            qsort(r->samples, r->n, sizeof(long long), cmp_ll);
+            double p50 = percentile(r, 0.50);
+            if (isa == KERNEL_SCALAR) {
+                scalar_p50 = p50;
+                continue;
+            }
+            printf("  %s x%.1f over scalar at %d players\n", tick_kernel_name(isa),
+                   p50 > 0 ? scalar_p50 / p50 : 0.0, n);
+            size_t bytes = n * sizeof(int);
+            if (memcmp(ref.energy, pl.energy, bytes) || memcmp(ref.is_fallen, pl.is_fallen, bytes) ||
+                memcmp(ref.fall_time_left, pl.fall_time_left, bytes) ||
+                memcmp(ref.effort, pl.effort, bytes)) {
+                fprintf(stderr, "tick_kernel %s differs from the scalar kernel at %d players\n",
+                        tick_kernel_name(isa), n);
+                exit(1);
+            }
+        }
+        lanes_free(&ref);
+        lanes_free(&pl);
+    }
+    tick_kernel_use(saved);
+}
+
+/* ---- dynamic_positions: full re-sort vs. incremental ranking ---- */
+
+/**
+ * Re-rank a team of n after every tick, once by sorting it again and once
+ * through a Ranking, and check both give the same locations. A dense tick
+ * is a kernel tick (every energy changes), a sparse one gives n / 64
+ * members a new energy.
+ */
+static void bench_rerank_team(int n, int sparse)
+{
+    const PlayerParams pp = { 50, 100, 1, 3, 1, 3 };
+    int ticks = iters / 10 > 0 ? iters / 10 : 1;
+    PlayerLanes pl;
+    Ranking rank;
+    RankEntry *sorted = malloc(n * sizeof(RankEntry));
+    if (lanes_init(&pl, n, 12345) != 0 || ranking_init(&rank, n) != 0 || !sorted) {
+        perror("rerank allocation failed");
+        exit(1);
+    }
+    lanes_reset_energy(&pl, &pp, 1);
+    ranking_build(&rank, pl.energy);
+
+    const char *kind = sparse ? "sparse" : "dense";
+    char name[64];
+    snprintf(name, sizeof(name), "rerank %s qsort (%d players)", kind, n);
+    BenchResult *full = new_result(name, ticks);
+    snprintf(name, sizeof(name), "rerank %s ranking (%d players)", kind, n);
+    BenchResult *inc = new_result(name, ticks);
+    int *changed = malloc((n / 64 + 1) * sizeof(int));
+    int n_changed = 0;
+    long long moves = 0;
+    uint32_t x = 1;
+    for (int k = 0; k < ticks; k++) {
+        if (sparse) {
+            n_changed = n / 64 + 1;
+            for (int c = 0; c < n_changed; c++) {
+                x = x * 1664525u + 1013904223u;
+                changed[c] = x % n;
+                pl.energy[changed[c]] = rng_range(x, pp.energy_min, pp.energy_max);
+            }
+        } else {
+            int sums[1] = {0};
+            if (k % 50 == 0)
+                lanes_reset_energy(&pl, &pp, k / 50 + 1);
+            tick_kernel(&pl, &pp, k / 50 + 1, k % 50 + 1, 1, n, sums);
+        }
+
+        long long t0 = mono_ns();
+        for (int i = 0; i < n; i++) {
+            sorted[i].index = i;
+            sorted[i].energy = pl.energy[i];
+        }
+        rank_by_energy(sorted, n);
+        for (int i = 0; i < n; i++)
+            pl.location[sorted[i].index] = i;
+        full->samples[full->n++] = mono_ns() - t0;
+
+        t0 = mono_ns();
+        if (sparse) {
+            for (int c = 0; c < n_changed; c++)
+                ranking_update(&rank, changed[c], pl.energy[changed[c]]);
+        } else {
+            for (int i = 0; i < n; i++)
+                ranking_update(&rank, i, pl.energy[i]);
+        }
+        moves += ranking_take_moved(&rank);
+        inc->samples[inc->n++] = mono_ns() - t0;
+
+        for (int i = 0; i < n; i++) {
+            if (rank.pos[i] != pl.location[i]) {
+                fprintf(stderr, "rerank: ranking differs from qsort at %d players\n", n);
+                exit(1);
+            }
+        }
+    }
+    printf("  rerank %s %d players: %.1f location changes per tick\n", kind, n,
+           (double)moves / ticks);
+    ranking_free(&rank);
+    lanes_free(&pl);
+    free(sorted);
+    free(changed);
+}
+
+static void bench_rerank(void)
+{
+    static const int counts[] = { 16, 256, 1024, 16384 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        bench_rerank_team(counts[c], 0);
+        bench_rerank_team(counts[c], 1);
+    }
+}
+
+typedef struct {
+    const char *name;     // --only selects by this name
+    void (*run)(void);
+} Bench;
+
+static const Bench benches[] = {
+    { "pipe",     bench_pipe_messages },
+    { "signal",   bench_signal_handler },
+    { "energy",   bench_energy_request },
+    { "assign",   bench_assign_locations },
+    { "shm",      bench_shm_slot },
+    { "thread",   bench_thread_request },
+    { "kernel",   bench_tick_kernel },
+    { "rerank",   bench_rerank },
+};
+
+static void print_results(void)
+{
+    printf("\n%-48s %8s %10s %10s %10s %10s %10s\n",
+           "path (us)", "n", "min", "p50", "p99", "p999", "max");
+    for (int i = 0; i < n_results; i++) {
+        BenchResult *r = &results[i];
+        if (r->n == 0)
+            continue;
+        printf("%-48s %8d %10.2f %10.2f %10.2f %10.2f %10.2f\n", r->name, r->n,
+               r->samples[0] / 1e3, percentile(r, 0.50) / 1e3, percentile(r, 0.99) / 1e3,
+               percentile(r, 0.999) / 1e3, r->samples[r->n - 1] / 1e3);
+    }
+}
+
+static int write_json(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        perror("Failed to open the JSON output");
+        return -1;
+    }
+    fprintf(fp, "{\n  \"iterations\": %d,\n  \"players\": %d,\n  \"unit\": \"ns\",\n"
+            "  \"results\": [\n", iters, bench_players);
+    int first = 1;
+    for (int i = 0; i < n_results; i++) {
+        BenchResult *r = &results[i];
+        if (r->n == 0)
+            continue;
+        fprintf(fp, "%s    {\"name\": \"%s\", \"n\": %d, \"min\": %lld, \"p50\": %lld, "
+                "\"p99\": %lld, \"p999\": %lld, \"max\": %lld, \"mean\": %.1f}",
+                first ? "" : ",\n", r->name, r->n, r->samples[0], percentile(r, 0.50),
+                percentile(r, 0.99), percentile(r, 0.999), r->samples[r->n - 1], mean_of(r));
+        first = 0;
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *out_path = "bench.json";
+    const char *only = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            bench_players = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            iters = 0;
+            break;
+        }
+    }
+    if (iters < 1 || bench_players < DEFAULT_TEAM_SIZE || bench_players % DEFAULT_TEAM_SIZE) {
+        fprintf(stderr, "Usage: %s [--iters N] [--players P] [--only NAME] [--out file.json]\n"
+                "  P is a multiple of %d, NAME one of:", argv[0], DEFAULT_TEAM_SIZE);
+        for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+            fprintf(stderr, " %s", benches[b].name);
+        fprintf(stderr, "\n");
+        return 1;
+    }
+
+    // A dead child shows up as a failed read, not a signal
+    signal(SIGPIPE, SIG_IGN);
+
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        if (only && strcmp(only, benches[b].name) != 0)
+            continue;
+        printf("[BENCH] %s...\n", benches[b].name);
+        fflush(stdout);
+        int first = n_results;
+        benches[b].run();
+        for (int i = first; i < n_results; i++)
+            qsort(results[i].samples, results[i].n, sizeof(long long), cmp_ll);
+    }
+
+    print_results();
+    if (write_json(out_path) != 0)
+        return 1;
+    printf("\nResults written to %s\n", out_path);
+    return 0;
+}
@@ -1,9 +1,103 @@
 // config.c
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "constant.h"
 #include "config.h"
 
+// Each with the range load_config() accepts for it on its own
+static const struct {
+    const char *name;
+    size_t offset;
+    int min;
+    int max;
+} live_keys[CONFIG_LIVE_KEYS] = {
+    { "energy_min",        offsetof(GameConfig, energy_min),        0, INT_MAX },
+    { "energy_max",        offsetof(GameConfig, energy_max),        0, INT_MAX },
+    { "decay_min",         offsetof(GameConfig, decay_min),         0, INT_MAX },
+    { "decay_max",         offsetof(GameConfig, decay_max),         0, INT_MAX },
+    { "fall_recover_min",  offsetof(GameConfig, fall_recover_min),  0, INT_MAX },
+    { "fall_recover_max",  offsetof(GameConfig, fall_recover_max),  0, INT_MAX },
+    { "win_threshold",     offsetof(GameConfig, win_threshold),     1, INT_MAX },
+    { "max_game_time",     offsetof(GameConfig, max_game_time),     1, INT_MAX },
+    { "max_score",         offsetof(GameConfig, max_score),         0, INT_MAX },
+    { "consecutive_wins",  offsetof(GameConfig, consecutive_wins),  1, INT_MAX },
+    { "dynamic_positions", offsetof(GameConfig, dynamic_positions), 0, 1 },
+};
+
+/**
+ * Parse a CPU list like "0-3,6" (or "any") into a mask => 0, or -1
+ */
+static int parse_cpus(const char *list, uint64_t *mask)
+{
+    *mask = 0;
+    if (strcmp(list, "any") == 0)
+        return 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (end == p)
+            return -1;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if (end == p)
+                return -1;
+        }
+        if (lo < 0 || hi < lo || hi > 63)
+            return -1;
+        for (long c = lo; c <= hi; c++)
+            *mask |= 1ULL << c;
+        if (*end == ',')
+            end++;
+        else if (*end != '\0')
+            return -1;
+        p = end;
+    }
+    return *mask ? 0 : -1;
+}
+
+/**
+ * Compiled config: map it and take the GameConfig, it was validated when
+ * it was compiled
+ */
+static int load_blob(const char *filename, GameConfig *cfg)
+{
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        perror("Failed to open config file");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size != sizeof(ConfigBlob)) {
+        printf("❌ Invalid compiled config %s! Compile it again.\n", filename);
+        close(fd);
+        return -1;
+    }
+    const ConfigBlob *blob = mmap(NULL, sizeof(ConfigBlob), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (blob == MAP_FAILED) {
+        perror("mmap config failed");
+        return -1;
+    }
+    int ok = blob->version == CONFIG_BLOB_VERSION && blob->size == sizeof(GameConfig);
+    if (ok)
+        *cfg = blob->cfg;
+    else
+        printf("❌ Compiled config %s is from another version! Compile it again.\n", filename);
+    munmap((void *)blob, sizeof(ConfigBlob));
+    return ok ? 0 : -1;
+}
+
 int load_config(const char *filename, GameConfig *cfg)
 {
     FILE *fp = fopen(filename, "r");
@@ -12,8 +106,35 @@ int load_config(const char *filename, GameConfig *cfg)
         return -1;
     }
 
+    char magic[sizeof(CONFIG_BLOB_MAGIC) - 1];
+    if (fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+        memcmp(magic, CONFIG_BLOB_MAGIC, sizeof(magic)) == 0) {
+        fclose(fp);
+        return load_blob(filename, cfg);
+    }
+    rewind(fp);
+
     char key[50];
     int read_values;
+
+    // Defaults for optional keys
+    cfg->ipc_mode = IPC_PIPE;
+    cfg->tick_hz = 1;
+    cfg->player_engine = ENGINE_PROCESS;
+    cfg->num_teams = DEFAULT_NUM_TEAMS;
+    cfg->team_size = DEFAULT_TEAM_SIZE;
+    cfg->graphics_feed = FEED_SHM;
+    cfg->dynamic_positions = 0;
+    cfg->graphics_policy = SINK_COALESCE;
+    cfg->json_policy = SINK_DROP_OLDEST;
+    cfg->telemetry_policy = SINK_DROP_OLDEST;
+    cfg->sink_queue = 64;
+    cfg->referee_priority = 0;
+    cfg->player_priority = 0;
+    cfg->referee_cpus = 0;
+    cfg->player_cpus = 0;
+    cfg->lock_memory = 0;
+    cfg->prefault_stack_kb = 0;
     
     while (fscanf(fp, "%s", key) != EOF) {
         if (strcmp(key, "energy_range") == 0) {
@@ -72,6 +193,148 @@ int load_config(const char *filename, GameConfig *cfg)
                 return -1;
             }
         } 
+        else if (strcmp(key, "tick_hz") == 0) {
+            read_values = fscanf(fp, "%d", &cfg->tick_hz);
+            if (read_values != 1 || cfg->tick_hz < 1 || cfg->tick_hz > 1000) {
+                printf("❌ Invalid tick_hz! Must be between 1 and 1000.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "num_teams") == 0) {
+            read_values = fscanf(fp, "%d", &cfg->num_teams);
+            if (read_values != 1 || cfg->num_teams < 2 || cfg->num_teams > MAX_TEAMS) {
+                printf("❌ Invalid num_teams! Must be between 2 and %d.\n", MAX_TEAMS);
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "team_size") == 0) {
+            read_values = fscanf(fp, "%d", &cfg->team_size);
+            if (read_values != 1 || cfg->team_size < 1 || cfg->team_size > MAX_TEAM_SIZE) {
+                printf("❌ Invalid team_size! Must be between 1 and %d.\n", MAX_TEAM_SIZE);
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "player_engine") == 0) {
+            char engine[16];
+            read_values = fscanf(fp, "%15s", engine);
+            if (read_values == 1 && strcmp(engine, "process") == 0) {
+                cfg->player_engine = ENGINE_PROCESS;
+            } else if (read_values == 1 && strcmp(engine, "thread") == 0) {
+                cfg->player_engine = ENGINE_THREAD;
+            } else {
+                printf("❌ Invalid player_engine! Must be process or thread.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "graphics_feed") == 0) {
+            char feed[16];
+            read_values = fscanf(fp, "%15s", feed);
+            if (read_values == 1 && strcmp(feed, "pipe") == 0) {
+                cfg->graphics_feed = FEED_PIPE;
+            } else if (read_values == 1 && strcmp(feed, "shm") == 0) {
+                cfg->graphics_feed = FEED_SHM;
+            } else {
+                printf("❌ Invalid graphics_feed! Must be pipe or shm.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "dynamic_positions") == 0) {
+            char mode[16];
+            read_values = fscanf(fp, "%15s", mode);
+            if (read_values == 1 && strcmp(mode, "off") == 0) {
+                cfg->dynamic_positions = 0;
+            } else if (read_values == 1 && strcmp(mode, "on") == 0) {
+                cfg->dynamic_positions = 1;
+            } else {
+                printf("❌ Invalid dynamic_positions! Must be on or off.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "graphics_policy") == 0 || strcmp(key, "json_policy") == 0 ||
+                 strcmp(key, "telemetry_policy") == 0) {
+            char policy[16];
+            int *value = key[0] == 'g' ? &cfg->graphics_policy
+                       : key[0] == 'j' ? &cfg->json_policy : &cfg->telemetry_policy;
+            read_values = fscanf(fp, "%15s", policy);
+            if (read_values == 1 && strcmp(policy, "coalesce") == 0) {
+                *value = SINK_COALESCE;
+            } else if (read_values == 1 && strcmp(policy, "drop_oldest") == 0) {
+                *value = SINK_DROP_OLDEST;
+            } else if (read_values == 1 && strcmp(policy, "block") == 0) {
+                *value = SINK_BLOCK;
+            } else {
+                printf("❌ Invalid %s! Must be coalesce, drop_oldest or block.\n", key);
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "sink_queue") == 0) {
+            read_values = fscanf(fp, "%d", &cfg->sink_queue);
+            if (read_values != 1 || cfg->sink_queue < 1 || cfg->sink_queue > 65536) {
+                printf("❌ Invalid sink_queue! Must be between 1 and 65536.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "sched_fifo") == 0) {
+            read_values = fscanf(fp, "%d %d", &cfg->referee_priority, &cfg->player_priority);
+            if (read_values != 2 || cfg->referee_priority < 0 || cfg->referee_priority > 99 ||
+                cfg->player_priority < 0 || cfg->player_priority > 99) {
+                printf("❌ Invalid sched_fifo! Must be two priorities between 0 (off) and 99.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "referee_cpus") == 0 || strcmp(key, "player_cpus") == 0) {
+            char list[64];
+            uint64_t *mask = key[0] == 'r' ? &cfg->referee_cpus : &cfg->player_cpus;
+            read_values = fscanf(fp, "%63s", list);
+            if (read_values != 1 || parse_cpus(list, mask) != 0) {
+                printf("❌ Invalid %s! Must be any or a list like 0-3,6 of CPUs below 64.\n", key);
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "lock_memory") == 0) {
+            char mode[16];
+            read_values = fscanf(fp, "%15s", mode);
+            if (read_values == 1 && strcmp(mode, "off") == 0) {
+                cfg->lock_memory = 0;
+            } else if (read_values == 1 && strcmp(mode, "on") == 0) {
+                cfg->lock_memory = 1;
+            } else {
+                printf("❌ Invalid lock_memory! Must be on or off.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "prefault_stack") == 0) {
+            read_values = fscanf(fp, "%d", &cfg->prefault_stack_kb);
+            if (read_values != 1 || cfg->prefault_stack_kb < 0 || cfg->prefault_stack_kb > 4096) {
+                printf("❌ Invalid prefault_stack! Must be between 0 and 4096 KB.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
+        else if (strcmp(key, "ipc_mode") == 0) {
+            char mode[16];
+            read_values = fscanf(fp, "%15s", mode);
+            if (read_values == 1 && strcmp(mode, "pipe") == 0) {
+                cfg->ipc_mode = IPC_PIPE;
+            } else if (read_values == 1 && strcmp(mode, "shm") == 0) {
+                cfg->ipc_mode = IPC_SHM;
+            } else {
+                printf("❌ Invalid ipc_mode! Must be pipe or shm.\n");
+                fclose(fp);
+                return -1;
+            }
+        } 
         else {
             printf("⚠️ Unknown config key: %s\n", key);
             fclose(fp);
@@ -81,4 +344,85 @@ int load_config(const char *filename, GameConfig *cfg)
     
     fclose(fp);
     return 0;
-}
\ No newline at end of file
+}
+
+int config_compile(const GameConfig *cfg, const char *path)
+{
+    ConfigBlob blob;
+    memset(&blob, 0, sizeof(blob));
+    memcpy(blob.magic, CONFIG_BLOB_MAGIC, sizeof(blob.magic));
+    blob.version = CONFIG_BLOB_VERSION;
+    blob.size = sizeof(GameConfig);
+    blob.cfg = *cfg;
+
+    // Renamed into place, so a running game never reads half of it
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) {
+        perror("Failed to create compiled config");
+        return -1;
+    }
+    int ok = fwrite(&blob, sizeof(blob), 1, fp) == 1;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp, path) == -1) {
+        perror("Failed to write compiled config");
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+const char *config_live_name(int k)
+{
+    return live_keys[k].name;
+}
+
+int *config_live_value(GameConfig *cfg, int k)
+{
+    return (int *)((char *)cfg + live_keys[k].offset);
+}
+
+int config_live_valid(int k, int value)
+{
+    return k >= 0 && k < CONFIG_LIVE_KEYS && value >= live_keys[k].min &&
+           value <= live_keys[k].max;
+}
+
+int config_live_consistent(const GameConfig *cfg)
+{
+    return cfg->energy_min <= cfg->energy_max && cfg->decay_min <= cfg->decay_max &&
+           cfg->fall_recover_min <= cfg->fall_recover_max;
+}
+
+int config_same_shape(const GameConfig *a, const GameConfig *b)
+{
+    return a->num_teams == b->num_teams && a->team_size == b->team_size &&
+           a->tick_hz == b->tick_hz && a->ipc_mode == b->ipc_mode &&
+           a->player_engine == b->player_engine && a->graphics_feed == b->graphics_feed &&
+           a->sink_queue == b->sink_queue && a->graphics_policy == b->graphics_policy &&
+           a->json_policy == b->json_policy && a->telemetry_policy == b->telemetry_policy &&
+           a->referee_priority == b->referee_priority &&
+           a->player_priority == b->player_priority && a->referee_cpus == b->referee_cpus &&
+           a->player_cpus == b->player_cpus && a->lock_memory == b->lock_memory &&
+           a->prefault_stack_kb == b->prefault_stack_kb;
+}
+
+int config_reload(GameConfig *cfg, const GameConfig *next, int changed[CONFIG_LIVE_KEYS])
+{
+    int n = 0;
+    for (int k = 0; k < CONFIG_LIVE_KEYS; k++) {
+        int *value = config_live_value(cfg, k);
+        int next_value = *config_live_value((GameConfig *)next, k);
+        if (*value != next_value) {
+            *value = next_value;
+            changed[n++] = k;
+        }
+    }
+
+    if (!config_same_shape(cfg, next)) {
+        printf("⚠️ num_teams, team_size, tick_hz, ipc_mode, player_engine, graphics_feed, "
+               "the sinks and the scheduling keys only change on restart, keeping them\n");
+    }
+    return n;
+}
@@ -2,6 +2,25 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <stdint.h>
+
+// Transport used for the per-tick player -> referee exchange
+#define IPC_PIPE 0   // a TickRecord per tick over pipes
+#define IPC_SHM  1   // players publish into shared-memory slots
+
+// How graphics gets the game state
+#define FEED_PIPE 0   // a GraphicsMessage per update over a pipe
+#define FEED_SHM  1   // latest-value GameState page (game_state.h)
+
+// What a telemetry sink (telemetry.h) does when its queue is full
+#define SINK_COALESCE     0   // replace the newest pending update, the latest matters most
+#define SINK_DROP_OLDEST  1   // drop the oldest pending update
+#define SINK_BLOCK        2   // the referee waits for room, nothing is lost
+
+// How players run
+#define ENGINE_PROCESS 0   // one ./player process per player
+#define ENGINE_THREAD  1   // one thread per player inside rope_game
+
 typedef struct {
     int energy_min;
     int energy_max;
@@ -16,8 +35,73 @@ typedef struct {
     int max_game_time;
     int max_score;
     int consecutive_wins;
+
+    int ipc_mode;
+    int tick_hz;       // ticks per second shared by the referee and the players
+    int player_engine; // ENGINE_PROCESS or ENGINE_THREAD
+
+    int num_teams;     // teams pulling the rope, 2..MAX_TEAMS
+    int team_size;     // players per team, 1..MAX_TEAM_SIZE
+
+    int graphics_feed; // FEED_PIPE or FEED_SHM
+
+    int dynamic_positions; // re-rank every tick from live energies (ranking.h)
+
+    int graphics_policy;   // SINK_* of the graphics pipe feed
+    int json_policy;       // SINK_* of the --json stream
+    int telemetry_policy;  // SINK_* of the --telemetry file
+    int sink_queue;        // pending updates each sink can hold
+
+    // Scheduling (tuning.h), all off by default
+    int referee_priority;  // SCHED_FIFO priority of the referee, 0 => normal scheduling
+    int player_priority;   // SCHED_FIFO priority of the players, 0 => normal scheduling
+    uint64_t referee_cpus; // CPUs the referee runs on, bit n => CPU n, 0 => any
+    uint64_t player_cpus;  // CPUs the players run on, 0 => any
+    int lock_memory;       // mlockall() the referee and the players
+    int prefault_stack_kb; // stack touched at startup, so ticks don't fault it in
 } GameConfig;
 
+// Compiled config (rope_game --compile-config): a validated GameConfig that
+// load_config() maps as is instead of parsing the text again
+#define CONFIG_BLOB_MAGIC    "ROPECFG1"
+#define CONFIG_BLOB_VERSION  3
+
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t size;       // sizeof(GameConfig) of the writer
+    GameConfig cfg;
+} ConfigBlob;
+
+// Keys a running game takes at the next round boundary (hot reload); the
+// others shape the processes and shared regions and need a restart
+#define CONFIG_LIVE_KEYS 11
+
+// Load a text config or a compiled one => 0, or -1 if it can't be read or
+// a key is unknown or invalid
 int load_config(const char *filename, GameConfig *cfg);
 
+// Write cfg as a compiled config, replacing path atomically => 0, or -1
+int config_compile(const GameConfig *cfg, const char *path);
+
+// Live key k: its name and its value in cfg
+const char *config_live_name(int k);
+int *config_live_value(GameConfig *cfg, int k);
+
+// Live key k exists and value is in the range load_config() accepts => 1
+int config_live_valid(int k, int value);
+
+// Every min/max pair of the live keys in order => 1
+int config_live_consistent(const GameConfig *cfg);
+
+// Same teams, tick_hz, transports, player engine, telemetry sinks and
+// scheduling (tuning.h) => 1: the keys that shape the processes, shared
+// regions and sinks of a game, all applied once at startup
+int config_same_shape(const GameConfig *a, const GameConfig *b);
+
+// Take every live key of next into cfg and store the indexes of the ones
+// that changed in changed[] => how many. Keys that need a restart are
+// left alone, with a warning if next changes them.
+int config_reload(GameConfig *cfg, const GameConfig *next, int changed[CONFIG_LIVE_KEYS]);
+
 #endif
@@ -1,11 +1,14 @@
 #ifndef COMM_H
 #define COMM_H
 
-#define MAX_PLAYERS  8
-#define TEAM_SIZE    4
+// Teams are sized at runtime (num_teams / team_size in the config file)
+#define DEFAULT_NUM_TEAMS  2
+#define DEFAULT_TEAM_SIZE  4
+#define MAX_TEAMS          8
+#define MAX_TEAM_SIZE      1024
 
 // Signal Assignments
-#define SIG_ENERGY_REQ   SIGUSR1      // Request energy report
+#define SIG_ENERGY_REQ   SIGUSR1      // Request a state report (TickRecord, tick 0)
 #define SIG_SET_LOC      SIGUSR2      // Assign location
 #define SIG_READY        SIGRTMIN     // Ready state (RT signal 0)
 #define SIG_PULL         (SIGRTMIN+1) // Start pulling (RT signal 1)
@@ -27,21 +30,21 @@ typedef struct {
     int fall_time_left;
 } PlayerData;
 
-// Weighted effort -> already used
+// Child -> Parent: the only message on the effort pipe. A player writes one
+// per tick it plays, and one with tick 0 for each SIG_ENERGY_REQ. The record
+// says which tick it is, so the referee never has to guess from the order.
 typedef struct {
     int player_id;
     int team;
-    int weighted_effort;
+    int round;           // round the tick belongs to
+    int tick;            // tick of that round, 1-based; 0 => state report
+    int energy;          // raw energy, after the tick
     int location;
-} EffortMessage;
-
-// Child -> Parent: raw energy
-typedef struct {
-    int player_id;
-    int team;
-    int energy; // raw
-    int location;
-} EnergyReply;
+    int is_fallen;
+    int fall_time_left;
+    int weighted_effort; // effort of the tick, 0 in a state report
+    unsigned int seq;    // records this player has sent before this one
+} TickRecord;
 
 // Parent -> Child: assigned location
 typedef struct {
@@ -49,14 +52,30 @@ typedef struct {
     int location;
 } LocationMessage;
 
-// Parent -> Graphics: real-time game state updates
+// Parent -> Graphics: real-time game state updates. Variable length, the
+// header is followed by int effortSums[numTeams] and then by
+// int energies[numTeams * teamSize], team after team.
+// stateNs dates the state on CLOCK_MONOTONIC, which graphics shares, so
+// graphics can place it in time however late it arrives.
 typedef struct {
-    int roundNumber;
-    int team1Energies[TEAM_SIZE];
-    int team2Energies[TEAM_SIZE];
-    int team1EffortSum;
-    int team2EffortSum;
-    int roundWinner; // 0 => none, 1 => Team1, 2 => Team2
+    int roundNumber; // -1 => final game message, effortSums hold the scores
+    int numTeams;
+    int teamSize;    // 0 in the final game message
+    int roundWinner; // 0 => none, t => Team t (1-based)
+    int tick;        // ticks of the round closed when the state was taken
+    long long stateNs;  // monotonic time of the state
+    long long tickNs;   // tick period, 0 => not paced (graphics shows each state as is)
 } GraphicsMessage;
 
+#define GRAPHICS_MSG_SIZE(teams, size) \
+    (sizeof(GraphicsMessage) + sizeof(int) * (size_t)(teams) * ((size) + 1))
+
+static inline int *graphics_sums(GraphicsMessage *msg) {
+    return (int *)(msg + 1);
+}
+
+static inline int *graphics_energies(GraphicsMessage *msg) {
+    return (int *)(msg + 1) + msg->numTeams;
+}
+
 #endif
\ No newline at end of file
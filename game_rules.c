@@ -0,0 +1,104 @@
+// game_rules.c
+#include <stdlib.h>
+#include "constant.h"
+#include "game_rules.h"
+
+void match_init(MatchScore *ms, int num_teams)
+{
+    ms->num_teams = num_teams;
+    for (int t = 0; t < num_teams; t++) {
+        ms->team_scores[t] = 0;
+        ms->consecutive_wins[t] = 0;
+    }
+    ms->last_winner = -1;
+}
+
+int leading_team(const int values[], int num_teams)
+{
+    int best = 0, tied = 0;
+    for (int t = 1; t < num_teams; t++) {
+        if (values[t] > values[best]) {
+            best = t;
+            tied = 0;
+        } else if (values[t] == values[best]) {
+            tied = 1;
+        }
+    }
+    return tied ? -1 : best;
+}
+
+/**
+ * Team that wins a decided round: the highest sum, the last of the tied
+ * teams on equality (Team2 in the original two-team game)
+ */
+static int round_leader(const int sums[], int num_teams)
+{
+    int best = 0;
+    for (int t = 1; t < num_teams; t++) {
+        if (sums[t] >= sums[best])
+            best = t;
+    }
+    return best;
+}
+
+int round_check(const GameConfig *cfg, const int sums[], long elapsed_s, int *time_up)
+{
+    *time_up = 0;
+
+    // Check if any team has reached the win threshold
+    for (int t = 0; t < cfg->num_teams; t++) {
+        if (sums[t] >= cfg->win_threshold)
+            return round_leader(sums, cfg->num_teams);
+    }
+
+    // Check if game time limit is reached
+    if (elapsed_s >= cfg->max_game_time) {
+        *time_up = 1;
+        return round_leader(sums, cfg->num_teams);
+    }
+    return -1;
+}
+
+void match_record(MatchScore *ms, int round_winner)
+{
+    ms->team_scores[round_winner]++;
+    if (round_winner == ms->last_winner) {
+        ms->consecutive_wins[round_winner]++;
+    } else {
+        for (int t = 0; t < ms->num_teams; t++)
+            ms->consecutive_wins[t] = 0;
+        ms->consecutive_wins[round_winner] = 1;
+    }
+    ms->last_winner = round_winner;
+}
+
+int match_check(const MatchScore *ms, const GameConfig *cfg, int round_winner, long elapsed_s)
+{
+    for (int t = 0; t < ms->num_teams; t++) {
+        if (ms->team_scores[t] >= cfg->max_score)
+            return END_MAX_SCORE;
+    }
+    if (ms->consecutive_wins[round_winner] >= cfg->consecutive_wins)
+        return END_CONSECUTIVE;
+    if (elapsed_s >= cfg->max_game_time)
+        return END_TIME_LIMIT;
+    return END_NONE;
+}
+
+int match_winner(const MatchScore *ms)
+{
+    return leading_team(ms->team_scores, ms->num_teams) + 1;
+}
+
+static int compare_rank(const void *a, const void *b)
+{
+    const RankEntry *ra = a, *rb = b;
+    if (ra->energy != rb->energy)
+        return (ra->energy < rb->energy) ? 1 : -1;
+    return (ra->index > rb->index) - (ra->index < rb->index);
+}
+
+void rank_by_energy(RankEntry *entries, int n)
+{
+    qsort(entries, n, sizeof(RankEntry), compare_rank);
+}
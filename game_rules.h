@@ -0,0 +1,62 @@
+// game_rules.h
+#ifndef GAME_RULES_H
+#define GAME_RULES_H
+
+#include "constant.h"
+#include "config.h"
+
+// Pauses between game phases (ms). The live referee waits for them in its
+// event loop, the virtual clock (sim.c) simply advances by them.
+#define SPAWN_SETTLE_MS     10    // Let players set up their signal loop
+#define LOCATION_SETTLE_MS  100   // Let players process the location message
+#define RESET_SETTLE_MS     100   // Let players process reset
+#define READY_DELAY_MS      1000  // Let them process the ready message
+#define PULL_SETTLE_MS      10    // Let them process the pull message
+#define STOP_SETTLE_MS      100   // Ensure players exit the pulling loop
+#define RESULT_PAUSE_MS     2000  // Time to view the results before next round
+#define FINAL_PAUSE_MS      1000  // Give graphics time to process
+
+// Why a game ended
+#define END_NONE         0
+#define END_MAX_SCORE    1
+#define END_CONSECUTIVE  2
+#define END_TIME_LIMIT   3
+
+// Scores carried from round to round
+typedef struct {
+    int num_teams;
+    int team_scores[MAX_TEAMS];        // Track team scores across rounds
+    int consecutive_wins[MAX_TEAMS];   // Track consecutive wins for end condition
+    int last_winner;
+} MatchScore;
+
+// One player in a location ranking
+typedef struct {
+    int index;    // referee index of the player
+    int energy;   // energy the ranking is based on
+} RankEntry;
+
+void match_init(MatchScore *ms, int num_teams);
+
+// Team with the highest value, or -1 if several teams share it
+int leading_team(const int values[], int num_teams);
+
+// Check the round after a tick => winning team, or -1 if it goes on.
+// sums holds the effort of each of the cfg->num_teams teams.
+// *time_up is set when the game time limit decided the round.
+int round_check(const GameConfig *cfg, const int sums[], long elapsed_s, int *time_up);
+
+// Sort a team by energy, highest first => entry i gets location i.
+// Equal energies keep the lower index first.
+void rank_by_energy(RankEntry *entries, int n);
+
+// Record the winner of a round
+void match_record(MatchScore *ms, int round_winner);
+
+// Check the end conditions after a round => END_*
+int match_check(const MatchScore *ms, const GameConfig *cfg, int round_winner, long elapsed_s);
+
+// Overall game winner => 1-based team, or 0 for a tie
+int match_winner(const MatchScore *ms);
+
+#endif
@@ -0,0 +1,120 @@
+// game_state.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "game_state.h"
+
+#define STATE_READ_RETRIES 64
+
+GameState *game_state_create(int num_teams, int team_size, int *fd_out)
+{
+    size_t size = sizeof(GameState) + (size_t)num_teams * team_size * sizeof(int);
+
+    // Close-on-exec: only graphics gets it, the referee clears the flag there
+    int fd = memfd_create("rope_game_state", MFD_CLOEXEC);
+    if (fd == -1) {
+        perror("memfd_create failed");
+        return NULL;
+    }
+    if (ftruncate(fd, size) == -1) {
+        perror("ftruncate game state failed");
+        close(fd);
+        return NULL;
+    }
+
+    GameState *gs = game_state_attach(fd);
+    if (!gs) {
+        close(fd);
+        return NULL;
+    }
+    memset(gs, 0, size);
+    gs->num_teams = num_teams;
+    gs->team_size = team_size;
+    gs->game_state = GS_WAITING;
+    *fd_out = fd;
+    return gs;
+}
+
+GameState *game_state_attach(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("fstat game state failed");
+        return NULL;
+    }
+    void *p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap game state failed");
+        return NULL;
+    }
+    return (GameState *)p;
+}
+
+int game_state_publish(GameState *gs, const GraphicsMessage *msg)
+{
+    const int *sums = graphics_sums((GraphicsMessage *)msg);
+    unsigned int s = atomic_load_explicit(&gs->seq, memory_order_relaxed);
+    int unread = s != 0 && atomic_load_explicit(&gs->seen_seq, memory_order_relaxed) != s;
+
+    // Odd => readers retry until we are done
+    atomic_store_explicit(&gs->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    gs->state_ns = msg->stateNs;
+    gs->tick_ns = msg->tickNs;
+    if (msg->roundNumber == -1) {
+        // Final game message: keep the last round on the page
+        gs->game_state = GS_GAME_OVER;
+        gs->game_winner = msg->roundWinner;
+        memcpy(gs->final_scores, sums, gs->num_teams * sizeof(int));
+    } else {
+        gs->round_number = msg->roundNumber;
+        gs->round_winner = msg->roundWinner;
+        gs->game_state = msg->roundWinner ? GS_ROUND_ENDED : GS_PLAYING;
+        gs->tick = msg->tick;
+        memcpy(gs->effort_sums, sums, gs->num_teams * sizeof(int));
+        memcpy(gs->energies, graphics_energies((GraphicsMessage *)msg),
+               (size_t)gs->num_teams * gs->team_size * sizeof(int));
+    }
+
+    atomic_store_explicit(&gs->seq, s + 2, memory_order_release);
+    return unread;
+}
+
+int game_state_read(GameState *gs, GameState *out, int *energies)
+{
+    for (int i = 0; i < STATE_READ_RETRIES; i++) {
+        unsigned int s1 = atomic_load_explicit(&gs->seq, memory_order_acquire);
+        if (s1 & 1)
+            continue;
+
+        out->num_teams = gs->num_teams;
+        out->team_size = gs->team_size;
+        out->round_number = gs->round_number;
+        out->round_winner = gs->round_winner;
+        out->game_state = gs->game_state;
+        out->game_winner = gs->game_winner;
+        out->tick = gs->tick;
+        out->state_ns = gs->state_ns;
+        out->tick_ns = gs->tick_ns;
+        memcpy(out->effort_sums, gs->effort_sums, sizeof(out->effort_sums));
+        memcpy(out->final_scores, gs->final_scores, sizeof(out->final_scores));
+        memcpy(energies, gs->energies, (size_t)gs->num_teams * gs->team_size * sizeof(int));
+
+        atomic_thread_fence(memory_order_acquire);
+        unsigned int s2 = atomic_load_explicit(&gs->seq, memory_order_relaxed);
+        if (s1 == s2) {
+            atomic_store_explicit(&out->seq, s1, memory_order_relaxed);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void game_state_seen(GameState *gs, unsigned int seq)
+{
+    atomic_store_explicit(&gs->seen_seq, seq, memory_order_relaxed);
+}
@@ -1,15 +1,53 @@
+// game_state.h
 #ifndef GAME_STATE_H
 #define GAME_STATE_H
 
+#include <stdatomic.h>
+#include "constant.h"
+
+// What the page shows
+#define GS_WAITING      0   // no round started yet
+#define GS_PLAYING      1   // round in progress
+#define GS_ROUND_ENDED  2   // round_winner is set
+#define GS_GAME_OVER    3   // final_scores and game_winner are set
+
+// Latest-value page shared by the referee and graphics (graphics_feed shm).
+// The referee overwrites it in place every tick, graphics copies it once per
+// frame, so there is never a backlog and the referee never waits.
+// seq is odd while the referee is writing and even once the page is stable.
 typedef struct {
-    float team1_energy[4];
-    float team2_energy[4];
+    atomic_uint seq;
+    atomic_uint seen_seq;           // last seq graphics copied, for the stats
+    int num_teams;                  // fixed when the page is created
+    int team_size;
     int round_number;
-    int team1_effort_sum;
-    int team2_effort_sum;
-    int round_winner;  // -1 if not determined yet, 0 for Team1, 1 for Team2
-    char status_message[50];  // For showing round info, winners, etc.
-    int game_state;    // 0: new round, 1: playing, 2: round ended
+    int round_winner;               // 0 => none, t => Team t (1-based)
+    int game_state;                 // GS_*
+    int game_winner;                // 0 => tie, t => Team t (GS_GAME_OVER)
+    int tick;                       // GraphicsMessage tick, stateNs, tickNs
+    long long state_ns;
+    long long tick_ns;
+    int effort_sums[MAX_TEAMS];
+    int final_scores[MAX_TEAMS];
+    int energies[];                 // team t, player i => t * team_size + i
 } GameState;
 
-#endif
\ No newline at end of file
+// Referee side: create the page, fd is passed to graphics
+GameState *game_state_create(int num_teams, int team_size, int *fd_out);
+
+// Graphics side: map the page inherited through fd
+GameState *game_state_attach(int fd);
+
+// Overwrite the page with a referee update (single writer) => 1 if the
+// update it replaced was never read, 0 otherwise
+int game_state_publish(GameState *gs, const GraphicsMessage *msg);
+
+// Copy a consistent snapshot: the header into out, the energies into
+// energies (num_teams * team_size ints) => 0 on success, -1 if the referee
+// kept the page busy for too long
+int game_state_read(GameState *gs, GameState *out, int *energies);
+
+// Graphics side: tell the referee the snapshot with this seq was used
+void game_state_seen(GameState *gs, unsigned int seq);
+
+#endif
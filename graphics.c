@@ -6,6 +6,10 @@
  * - Shows animated player characters with energy bars
  * - Visualizes the rope position based on team efforts
  * - Displays round and game statistics
+ *
+ * The scenery and the players go through the instanced renderer of
+ * renderer.c when the GL context has OpenGL 3.3, the immediate-mode
+ * drawing below is the fallback.
  */
 
 #include <GL/glut.h>
@@ -13,40 +17,99 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <sys/select.h>
+#include <time.h>
 
 #include "constant.h"
-
-// Team data
-static float team1[TEAM_SIZE] = {80, 70, 60, 50};  // Blue team
-static float team2[TEAM_SIZE] = {60, 55, 40, 35};  // Red team
+#include "game_state.h"
+#include "pipe_feed.h"
+#include "renderer.h"
+#include "text.h"
+
+// Team data, sized by the first update: team t, player i => t * team_size + i
+static int num_teams = 2;
+static int team_size = 0;
+static float *energies = NULL;
+static PlayerInstance *instances = NULL;   // instanced renderer input, same order
+
+// Body colors; even teams pull to the left, odd teams to the right
+static const float team_colors[MAX_TEAMS][3] = {
+    {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.6f, 0.0f}, {0.9f, 0.6f, 0.0f},
+    {0.5f, 0.0f, 0.7f}, {0.0f, 0.6f, 0.6f}, {0.4f, 0.25f, 0.1f}, {0.9f, 0.3f, 0.6f}
+};
 
 // Game state
 static int round_number = 0;
-static int sum_t1 = 0;
-static int sum_t2 = 0;
-static int round_winner = 0;  // 0=none, 1=Team1, 2=Team2
-
-// Rope movement
-static float currentOffset = 0.0f;
-static float targetOffset = 0.0f;
+static int team_sums[MAX_TEAMS];
+static int round_winner = 0;  // 0=none, t=Team t
+
+// Rope movement. The rope is played back from the referee's last two
+// states, dated on its monotonic clock, ROPE_DELAY behind it: normally the
+// shown time falls between the two and the rope is interpolated; when the
+// next state is late it goes on the same way for up to ROPE_MAX_LEAD ticks,
+// then waits.
+#define FRAME_MS       16       // update() period
+#define ROPE_MAX_LEAD  1.0f     // ticks past the latest state
+#define ROPE_REACH     0.3f     // offset of a team pulling alone
+static float currentOffset = 0.0f;     // shown this frame
+static float targetOffset = 0.0f;      // of the latest state
+static float ropeFrom = 0.0f, ropeTo = 0.0f;
+static long long ropeFromNs = 0, ropeToNs = 0;
+static long long ropeTickNs = 0;       // referee's tick period, 0 => show the latest as is
+static long long ropeDelayNs = 0;      // one tick and one frame
+static int ropeRound = 0;
 static char status_message[50] = "";
 
-// Pipe for reading from parent process
-static int pipe_fd = -1;
+// The referee's updates come through the pipe, folded into snapshots by the
+// ingest thread of pipe_feed.c, or through its latest-state page (--shm).
+// Either way display() takes the newest state once per frame.
+static GameState *shared_state = NULL;
+static GameState state_snap;            // last consistent copy of its header
+static int *state_energies = NULL;      // and of its energies
+static unsigned int state_seq = 0;      // page version already shown
 
 // Game end state
 static int game_over = 0;
 static int game_winner = 0;
-static int final_score_team1 = 0;
-static int final_score_team2 = 0;
+static int final_scores[MAX_TEAMS];
 
 // Animation variables
 static float cloudX = -1.0f;  // Cloud position 
 static float bobFrame = 0.0f; // Player bobbing animation
 
+// Renderer
+static int retained = 0;                        // renderer.c is drawing
+static float circle[CIRCLE_SEGMENTS][2];        // unit circle of the fallback
+
+// Text (text.h): the labels change with the game state, not every frame
+static const float black[3] = {0.0f, 0.0f, 0.0f};
+static TextBatch world_text;          // HUD and energy labels
+static TextBatch overlay_text;        // game over banner, above its overlay
+static int label_round, label_efforts, label_status, label_round_winner;
+static int label_energy0;             // first of the energy labels, one per player
+static int label_game_over, label_final_score, label_game_winner;
+
+/**
+ * Fill the unit circle once instead of 360 cosf/sinf pairs per circle drawn
+ */
+void initCircle() {
+    for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+        float theta = 2.0f * (float)M_PI * i / CIRCLE_SEGMENTS;
+        circle[i][0] = cosf(theta);
+        circle[i][1] = sinf(theta);
+    }
+}
+
+/**
+ * Ellipse around (cx, cy) from the unit circle
+ */
+void drawEllipse(float cx, float cy, float rx, float ry) {
+    glBegin(GL_POLYGON);
+    for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+        glVertex2f(cx + rx * circle[i][0], cy + ry * circle[i][1]);
+    }
+    glEnd();
+}
+
 /**
  * Draw gradient sky-to-grass background
  */
@@ -66,13 +129,7 @@ void drawGradientBackground() {
  */
 void drawSun() {
     glColor3f(1.0f, 1.0f, 0.0f);
-    float cx = -0.85f, cy = 0.85f, r = 0.08f;
-    glBegin(GL_POLYGON);
-    for (int i = 0; i < 360; ++i) {
-        float theta = i * 3.14159f / 180.0f;
-        glVertex2f(cx + r * cosf(theta), cy + r * sinf(theta));
-    }
-    glEnd();
+    drawEllipse(-0.85f, 0.85f, 0.08f, 0.08f);
 }
 
 /**
@@ -82,40 +139,10 @@ void drawCloud(float x, float y) {
     glColor3f(1.0f, 1.0f, 1.0f);
     // Draw 3 overlapping circles
     for (int i = -1; i <= 1; ++i) {
-        glBegin(GL_POLYGON);
-        for (int j = 0; j < 360; ++j) {
-            float theta = j * 3.14159f / 180.0f;
-            glVertex2f(x + i * 0.05f + 0.04f * cosf(theta),
-                    y + 0.03f * sinf(theta));
-        }
-        glEnd();
+        drawEllipse(x + i * 0.05f, y, 0.04f, 0.03f);
     }
 }
 
-/**
- * Comparison function for descending sort of energy values
- */
-int compareDesc(const void* a, const void* b) {
-    float fa = *(const float*)a;
-    float fb = *(const float*)b;
-    return (fa < fb) - (fa > fb);
-}
-
-/**
- * Draw energy value text
- */
-void drawEnergyText(float x, float y, float energy) {
-    char buffer[16];
-    snprintf(buffer, sizeof(buffer), "%.0f", energy);
-    glColor3f(0.0f, 0.0f, 0.0f);
-    glRasterPos2f(x - 0.01f, y + 0.03f);
-    for (int i = 0; buffer[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, buffer[i]);
-    }
-}
-
-
-
 /**
  * Draw energy bar under player
  */
@@ -166,12 +193,7 @@ void drawPlayer(float baseX, float baseY, int flipped, float r, float g, float b
         glColor3f(1.0f, 0.8f, 0.6f);
 
     // Draw head (circle)
-    glBegin(GL_POLYGON);
-    for (int i = 0; i < 360; i++) {
-        float theta = i * 3.14159f / 180.0f;
-        glVertex2f(x + 0.02f * cosf(theta), y + 0.02f * sinf(theta));
-    }
-    glEnd();
+    drawEllipse(x, y, 0.02f, 0.02f);
 
     // Draw eyes
     glColor3f(0, 0, 0);
@@ -208,9 +230,8 @@ void drawPlayer(float baseX, float baseY, int flipped, float r, float g, float b
         glVertex2f(x + 0.01f, y - 0.11f);
     glEnd();
 
-    // Draw energy bar and labels
+    // Draw energy bar, the label is drawn with the other text
     drawEnergyBar(x, y, energy);
-    drawEnergyText(x, y, energy);
 }
 
 /**
@@ -231,143 +252,322 @@ void incrementBobFrame() {
 }
 
 /**
- * Main update function - reads pipe data and updates game state
+ * Where player i of team t stands with the rope at rest, a row per pair of
+ * teams: even teams on the left facing right, odd teams on the right
+ * facing left. Spacing shrinks for large teams.
  */
-void update(int value) {
-    // Update bobbing animation
-    incrementBobFrame();
+void playerBase(int t, int i, float *x, float *y) {
+    float spacing = team_size > 4 ? 0.6f / team_size : 0.15f;
+    *x = (t % 2 == 0) ? -0.7f + i * spacing : 0.7f - i * spacing;
+    *y = 0.05f - (t / 2) * 0.3f;
+}
 
-    // Setup non-blocking read
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(pipe_fd, &readfds);
-
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = 0;
-
-    while (select(pipe_fd + 1, &readfds, NULL, NULL, &tv) > 0) {
-        GraphicsMessage msg;
-        int bytes = read(pipe_fd, &msg, sizeof(msg));
-        if (bytes == sizeof(msg)) {
-            // Check if this is a game-end message
-            if (msg.roundNumber == -1) {
-                game_over = 1;
-                game_winner = msg.roundWinner;
-                final_score_team1 = msg.team1EffortSum;
-                final_score_team2 = msg.team2EffortSum;
-                snprintf(status_message, sizeof(status_message), "Game Over!");
-            } else {
-                // Regular round update
-                round_number = msg.roundNumber;
-                for (int i = 0; i < TEAM_SIZE; i++) {
-                    team1[i] = msg.team1Energies[i];
-                    team2[i] = msg.team2Energies[i];
-                }
-                sum_t1 = msg.team1EffortSum;
-                sum_t2 = msg.team2EffortSum;
-                round_winner = msg.roundWinner;
-
-                // Calculate rope position based on team efforts
-                float total = sum_t1 + sum_t2;
-                if (total > 0.1f) {
-                    targetOffset = (sum_t2 - sum_t1) / total * 0.3f;
-                } else {
-                    targetOffset = 0.0f;
-                }
-
-                // Update status message
-                if (round_winner == 1)
-                    snprintf(status_message, sizeof(status_message),
-                            "Team 1 Wins Round %d!", round_number);
-                else if (round_winner == 2)
-                    snprintf(status_message, sizeof(status_message),
-                            "Team 2 Wins Round %d!", round_number);
-                else
-                    snprintf(status_message, sizeof(status_message),
-                            "Round %d in progress...", round_number);
-            }
-        } else {
-            // EOF or error
-            break;
+/**
+ * Create the labels for the current teams
+ */
+void setupLabels() {
+    text_clear(&world_text);
+    label_round = text_label(&world_text, TEXT_LARGE, 16);
+    label_efforts = text_label(&world_text, TEXT_LARGE, 24 * MAX_TEAMS);
+    label_status = text_label(&world_text, TEXT_LARGE, 48);
+    label_round_winner = text_label(&world_text, TEXT_LARGE, 24);
+    text_place(&world_text, label_round, -0.9f, 0.9f, black, 0, TEXT_NO_BOB);
+    text_place(&world_text, label_status, -0.1f, 0.7f, black, 0, TEXT_NO_BOB);
+    text_place(&world_text, label_round_winner, 0.5f, 0.9f, black, 0, TEXT_NO_BOB);
+    text_place(&world_text, label_efforts, num_teams > 2 ? -0.6f : -0.25f, 0.8f, black, 0,
+               TEXT_NO_BOB);
+
+    // Energy labels move with the rope and bob with their player
+    label_energy0 = -1;
+    for (int t = 0; t < num_teams; t++) {
+        for (int i = 0; i < team_size; i++) {
+            float x, y;
+            int id = text_label(&world_text, TEXT_SMALL, 8);
+            if (label_energy0 < 0)
+                label_energy0 = id;
+            playerBase(t, i, &x, &y);
+            text_place(&world_text, id, x - 0.01f, y + 0.03f, black, 1, i * 1.0f);
         }
-        FD_ZERO(&readfds);
-        FD_SET(pipe_fd, &readfds);
     }
 
-    // Smoothly move rope
-    float speed = 0.002f;
-    if (fabsf(currentOffset - targetOffset) > speed) {
-        currentOffset += (currentOffset < targetOffset) ? speed : -speed;
+    text_clear(&overlay_text);
+    label_game_over = text_label(&overlay_text, TEXT_LARGE, 16);
+    label_final_score = text_label(&overlay_text, TEXT_LARGE, 16 + 8 * MAX_TEAMS);
+    label_game_winner = text_label(&overlay_text, TEXT_LARGE, 32);
+    text_place(&overlay_text, label_game_over, -0.5f, 0.3f, black, 0, TEXT_NO_BOB);
+    text_place(&overlay_text, label_final_score, -0.5f, 0.2f, black, 0, TEXT_NO_BOB);
+    text_place(&overlay_text, label_game_winner, -0.5f, 0.0f, black, 0, TEXT_NO_BOB);
+    text_set(&overlay_text, label_game_over, "GAME OVER");
+}
+
+/**
+ * Bring the labels in line with the game state. Only labels whose text
+ * changed are formatted and laid out again (text.h).
+ */
+void updateLabels() {
+    text_set_int(&world_text, label_round, "Round %d", round_number);
+
+    char effortStr[200];
+    int len = 0;
+    for (int t = 0; t < num_teams; t++) {
+        len += snprintf(effortStr + len, sizeof(effortStr) - len, "%sTeam %d: %d",
+                        t ? " | " : "", t + 1, team_sums[t]);
+    }
+    text_set(&world_text, label_efforts, effortStr);
+
+    for (int k = 0; k < num_teams * team_size; k++) {
+        text_set_int(&world_text, label_energy0 + k, "%d", (int)lroundf(energies[k]));
+    }
+
+    if (game_over) {
+        // The banner replaces the round messages
+        text_set(&world_text, label_status, "");
+        text_set(&world_text, label_round_winner, "");
+
+        char finalScore[200];
+        len = snprintf(finalScore, sizeof(finalScore), "Final Score:");
+        for (int t = 0; t < num_teams; t++) {
+            len += snprintf(finalScore + len, sizeof(finalScore) - len, "%s T%d=%d",
+                            t ? "," : "", t + 1, final_scores[t]);
+        }
+        text_set(&overlay_text, label_final_score, finalScore);
+        if (game_winner > 0)
+            text_set_int(&overlay_text, label_game_winner, "TEAM %d WINS THE GAME!", game_winner);
+        else
+            text_set(&overlay_text, label_game_winner, "THE GAME IS A TIE!");
     } else {
-        currentOffset = targetOffset;
+        text_set(&world_text, label_status, status_message);
+        if (round_winner > 0)
+            text_set_int(&world_text, label_round_winner, "Team %d Wins!", round_winner);
+        else
+            text_set(&world_text, label_round_winner, "");
     }
+}
 
-    // Trigger redisplay
-    glutPostRedisplay();
-    glutTimerFunc(16, update, 0);
+/**
+ * Show the end of the game with the final team scores
+ */
+void set_game_over(int winner, const int scores[], int teams) {
+    game_over = 1;
+    game_winner = winner;
+    for (int t = 0; t < teams; t++)
+        final_scores[t] = scores[t];
+    snprintf(status_message, sizeof(status_message), "Game Over!");
+    updateLabels();
 }
 
 /**
- * Main display function
+ * Show the latest state of the round
  */
-void display() {
-    glClear(GL_COLOR_BUFFER_BIT);
+void set_round(int round, int winner, const int sums[], const int *msg_energies,
+               int teams, int size) {
+    if (teams != num_teams || size != team_size) {
+        num_teams = teams;
+        team_size = size;
+        energies = realloc(energies, num_teams * team_size * sizeof(float));
+        instances = realloc(instances, num_teams * team_size * sizeof(PlayerInstance));
+        if (!energies || !instances) {
+            perror("realloc failed");
+            exit(1);
+        }
+        setupLabels();
+    }
+    round_number = round;
+    for (int i = 0; i < num_teams * team_size; i++) {
+        energies[i] = msg_energies[i];
+    }
+    for (int t = 0; t < num_teams; t++) {
+        team_sums[t] = sums[t];
+    }
+    round_winner = winner;
+
+    // Calculate rope position based on the efforts of both sides
+    float left = 0.0f, right = 0.0f;
+    for (int t = 0; t < num_teams; t++) {
+        if (t % 2 == 0)
+            left += team_sums[t];
+        else
+            right += team_sums[t];
+    }
+    float total = left + right;
+    if (total > 0.1f) {
+        targetOffset = (right - left) / total * ROPE_REACH;
+    } else {
+        targetOffset = 0.0f;
+    }
 
-    // Draw background elements
-    drawGradientBackground();
-    drawSun();
-    drawCloud(cloudX, 0.85f);
+    // Update status message
+    if (round_winner > 0)
+        snprintf(status_message, sizeof(status_message),
+                "Team %d Wins Round %d!", round_winner, round_number);
+    else
+        snprintf(status_message, sizeof(status_message),
+                "Round %d in progress...", round_number);
+    updateLabels();
+}
 
-    // Draw rope
-    glColor3f(0.4f, 0.2f, 0.0f);
-    glBegin(GL_QUADS);
-        glVertex2f(-0.9f + currentOffset, 0.0f - 0.01f);
-        glVertex2f(0.9f + currentOffset, 0.0f - 0.01f);
-        glVertex2f(0.9f + currentOffset, 0.0f + 0.01f);
-        glVertex2f(-0.9f + currentOffset, 0.0f + 0.01f);
-    glEnd();
+long long monoNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-    // Copy and sort player energy values
-    float sorted1[TEAM_SIZE], sorted2[TEAM_SIZE];
-    memcpy(sorted1, team1, sizeof(team1));
-    memcpy(sorted2, team2, sizeof(team2));
-    qsort(sorted1, TEAM_SIZE, sizeof(float), compareDesc);
-    qsort(sorted2, TEAM_SIZE, sizeof(float), compareDesc);
-
-    // Draw blue team
-    for (int i = 0; i < TEAM_SIZE; i++) {
-        float baseX = -0.7f + i * 0.15f + currentOffset;
-        float baseY = 0.05f;
-        // flipped=1 => arms pointing right
-        drawPlayer(baseX, baseY, 1, 0.0f, 0.0f, 1.0f, team1[i], i);
+/**
+ * Rope offset at monotonic time t, from the last two states
+ */
+float ropeOffsetAt(long long t) {
+    long long span = ropeToNs - ropeFromNs;
+    if (ropeTickNs <= 0 || span <= 0)
+        return ropeTo;
+    long long limit = ropeToNs + (long long)(ROPE_MAX_LEAD * ropeTickNs);
+    if (t < ropeFromNs)
+        t = ropeFromNs;
+    if (t > limit)
+        t = limit;
+    float x = ropeFrom + (ropeTo - ropeFrom) * (float)(t - ropeFromNs) / (float)span;
+    return fmaxf(-ROPE_REACH, fminf(ROPE_REACH, x));
+}
+
+/**
+ * targetOffset is the rope of the state the referee took at state_ns
+ */
+void addRopeState(int round, long long state_ns, long long tick_ns) {
+    long long delay = tick_ns + FRAME_MS * 1000000LL;
+    long long shown_ns = monoNs() - delay;
+    if (round != ropeRound || tick_ns <= 0 || state_ns <= shown_ns) {
+        // New round, unpaced feed, or already due: go straight there
+        ropeFrom = ropeTo = targetOffset;
+        ropeFromNs = ropeToNs = state_ns;
+    } else {
+        // From where the rope is shown now, so it never jumps
+        ropeFrom = ropeOffsetAt(shown_ns);
+        ropeFromNs = shown_ns;
+        ropeTo = targetOffset;
+        ropeToNs = state_ns;
     }
+    ropeRound = round;
+    ropeTickNs = tick_ns;
+    ropeDelayNs = delay;
+}
+
+/**
+ * Show a snapshot of the game, from either feed
+ */
+void show_snapshot(const GameState *s, const int *snap_energies) {
+    if (s->game_state == GS_WAITING)
+        return;
+    if (s->game_state != GS_GAME_OVER)
+        game_over = 0;   // next game of a daemon referee
+    set_round(s->round_number, s->round_winner, s->effort_sums, snap_energies,
+              s->num_teams, s->team_size);
+    addRopeState(s->round_number, s->state_ns, s->tick_ns);
+    if (s->game_state == GS_GAME_OVER)
+        set_game_over(s->game_winner, s->final_scores, s->num_teams);
+}
+
+/**
+ * Shm feed: copy the page if the referee changed it since the last frame.
+ * Intermediate states the referee overwrote are simply never seen.
+ */
+void read_shared_state() {
+    unsigned int seq = atomic_load_explicit(&shared_state->seq, memory_order_acquire);
+    if (seq == state_seq || game_state_read(shared_state, &state_snap, state_energies) != 0)
+        return;   // nothing new, or busy => keep the last frame's state
+    state_seq = atomic_load_explicit(&state_snap.seq, memory_order_relaxed);
+    game_state_seen(shared_state, state_seq);
+    show_snapshot(&state_snap, state_energies);
+}
 
-    // Draw red team
-    for (int i = 0; i < TEAM_SIZE; i++) {
-        float baseX = 0.7f - i * 0.15f + currentOffset;
-        float baseY = 0.05f;
-        // flipped=-1 => arms pointing left
-        drawPlayer(baseX, baseY, -1, 1.0f, 0.0f, 0.0f, team2[i], i);
+/**
+ * Take the newest state either feed has, without waiting for the referee
+ */
+void takeLatestState() {
+    if (shared_state) {
+        read_shared_state();
+    } else {
+        const GameState *snap = pipe_feed_latest();
+        if (snap)
+            show_snapshot(snap, snap->energies);
     }
+}
 
-    // Draw round number
-    char roundStr[50];
-    snprintf(roundStr, sizeof(roundStr), "Round %d", round_number);
-    glColor3f(0, 0, 0);
-    glRasterPos2f(-0.9f, 0.9f);
-    for(int i = 0; roundStr[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, roundStr[i]);
+/**
+ * Animation step. The game state and the rope are taken by display().
+ */
+void update(int value) {
+    // Update bobbing animation
+    incrementBobFrame();
+
+    // Trigger redisplay
+    glutPostRedisplay();
+    glutTimerFunc(FRAME_MS, update, 0);
+}
+
+/**
+ * Every player in one instanced draw
+ */
+void drawPlayersInstanced() {
+    int n = num_teams * team_size;
+    for (int t = 0; t < num_teams && team_size > 0; t++) {
+        for (int i = 0; i < team_size; i++) {
+            PlayerInstance *p = &instances[t * team_size + i];
+            playerBase(t, i, &p->x, &p->y);
+            p->x += currentOffset;
+            p->r = team_colors[t][0];
+            p->g = team_colors[t][1];
+            p->b = team_colors[t][2];
+            p->energy = energies[t * team_size + i];
+            p->phase = i * 1.0f;   // keeps the players of a team out of sync
+            p->facing = (t % 2 == 0) ? 1.0f : -1.0f;
+        }
     }
+    renderer_draw_players(instances, n, bobFrame, round_winner == 0);
+}
 
-    // Draw team efforts
-    char effortStr[100];
-    snprintf(effortStr, sizeof(effortStr), "Team 1: %d | Team 2: %d", sum_t1, sum_t2);
-    glRasterPos2f(-0.25f, 0.8f);
-    for(int i = 0; effortStr[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, effortStr[i]);
+/**
+ * Main display function
+ */
+void display() {
+    takeLatestState();
+    currentOffset = ropeOffsetAt(monoNs() - ropeDelayNs);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (retained) {
+        // Static buffers, one instanced draw for all players
+        renderer_draw_scenery(cloudX);
+        renderer_draw_rope(currentOffset);
+        drawPlayersInstanced();
+    } else {
+        // Draw background elements
+        drawGradientBackground();
+        drawSun();
+        drawCloud(cloudX, 0.85f);
+
+        // Draw rope
+        glColor3f(0.4f, 0.2f, 0.0f);
+        glBegin(GL_QUADS);
+            glVertex2f(-0.9f + currentOffset, 0.0f - 0.01f);
+            glVertex2f(0.9f + currentOffset, 0.0f - 0.01f);
+            glVertex2f(0.9f + currentOffset, 0.0f + 0.01f);
+            glVertex2f(-0.9f + currentOffset, 0.0f + 0.01f);
+        glEnd();
+
+        for (int t = 0; t < num_teams && team_size > 0; t++) {
+            const float *color = team_colors[t];
+            for (int i = 0; i < team_size; i++) {
+                float x, y;
+                playerBase(t, i, &x, &y);
+                x += currentOffset;
+                // flipped=1 => arms pointing right, flipped=-1 => arms pointing left
+                drawPlayer(x, y, (t % 2 == 0) ? 1 : -1,
+                           color[0], color[1], color[2], energies[t * team_size + i], i);
+            }
+        }
     }
 
+    // Round, efforts, status and energy labels in one go
+    text_draw(&world_text, currentOffset, bobFrame, round_winner == 0);
+
     // Display game over screen if game has ended
     if (game_over) {
         // Semi-transparent overlay
@@ -379,66 +579,8 @@ void display() {
             glVertex2f(-0.6f, -0.4f);
         glEnd();
 
-        glColor3f(0, 0, 0);
-        // Game over text
-        glRasterPos2f(-0.5f, 0.3f);
-        const char *overText = "GAME OVER";
-        for(int i = 0; overText[i] != '\0'; i++) {
-            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, overText[i]);
-        }
-
-        // Final score
-        char finalScore[100];
-        snprintf(finalScore, sizeof(finalScore), "Final Score: T1=%d, T2=%d",
-                final_score_team1, final_score_team2);
-        glRasterPos2f(-0.5f, 0.2f);
-        for(int i = 0; finalScore[i] != '\0'; i++) {
-            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, finalScore[i]);
-        }
-
-        // Show winner
-        if (game_winner == 1) {
-            glRasterPos2f(-0.5f, 0.0f);
-            const char* wmsg = "TEAM 1 WINS THE GAME!";
-            for(int i = 0; wmsg[i] != '\0'; i++) {
-                glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, wmsg[i]);
-            }
-        } else if (game_winner == 2) {
-            glRasterPos2f(-0.5f, 0.0f);
-            const char* wmsg = "TEAM 2 WINS THE GAME!";
-            for(int i = 0; wmsg[i] != '\0'; i++) {
-                glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, wmsg[i]);
-            }
-        } else {
-            glRasterPos2f(-0.5f, 0.0f);
-            const char* tieMsg = "THE GAME IS A TIE!";
-            for(int i = 0; tieMsg[i] != '\0'; i++) {
-                glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, tieMsg[i]);
-            }
-        }
-    } else {
-        // Show round winner if determined
-        if (round_winner == 1) {
-            glRasterPos2f(0.5f, 0.9f);
-            const char* msgW = "Team 1 Wins!";
-            for(int i = 0; msgW[i] != '\0'; i++) {
-                glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, msgW[i]);
-            }
-        } else if (round_winner == 2) {
-            glRasterPos2f(0.5f, 0.9f);
-            const char* msgW2 = "Team 2 Wins!";
-            for(int i = 0; msgW2[i] != '\0'; i++) {
-                glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, msgW2[i]);
-            }
-        }
-
-        // Display status message
-        if (status_message[0] != '\0') {
-            glRasterPos2f(-0.1f, 0.7f);
-            for(int i = 0; status_message[i] != '\0'; i++) {
-                glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, status_message[i]);
-            }
-        }
+        // Game over text, final score and winner
+        text_draw(&overlay_text, 0.0f, 0.0f, 0);
     }
 
     glutSwapBuffers();
@@ -457,8 +599,8 @@ void keyboard(unsigned char key, int x, int y) {
  * Setup timer callbacks
  */
 void mainUpdateSetup() {
-    glutTimerFunc(16, update, 0);      // Rope movement and animations
-    glutTimerFunc(30, updateCloud, 0); // Cloud movement
+    glutTimerFunc(FRAME_MS, update, 0);  // Animations and redisplay
+    glutTimerFunc(30, updateCloud, 0);   // Cloud movement
 }
 
 /**
@@ -470,18 +612,33 @@ int main(int argc, char** argv) {
     glutInitWindowSize(800, 600);
     glutCreateWindow("Rope Pulling Game Visualization");
 
-    // Get pipe fd from command line
-    if (argc > 1) {
-        pipe_fd = atoi(argv[1]);
-        // Set non-blocking mode
-        int flags = fcntl(pipe_fd, F_GETFL, 0);
-        fcntl(pipe_fd, F_SETFL, flags | O_NONBLOCK);
+    // Get the shared page or the pipe fd from command line
+    if (argc > 2 && strcmp(argv[1], "--shm") == 0) {
+        shared_state = game_state_attach(atoi(argv[2]));
+        if (!shared_state)
+            return 1;
+        state_energies = calloc(shared_state->num_teams * shared_state->team_size, sizeof(int));
+        if (!state_energies) {
+            perror("calloc failed");
+            return 1;
+        }
+    } else if (argc > 1) {
+        if (pipe_feed_start(atoi(argv[1])) != 0)
+            return 1;
     } else {
-        fprintf(stderr, "No pipe fd provided\n");
+        fprintf(stderr, "Usage: %s <pipe_fd> | --shm <state_fd>\n", argv[0]);
         return 1;
     }
 
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    initCircle();
+    retained = renderer_init() == 0;
+    if (retained)
+        text_init();
+    text_batch_init(&world_text);
+    text_batch_init(&overlay_text);
+    setupLabels();
+    updateLabels();
 
     glutDisplayFunc(display);
     glutKeyboardFunc(keyboard);
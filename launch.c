@@ -0,0 +1,111 @@
+// launch.c
+#define _GNU_SOURCE   // posix_spawn_file_actions_addclosefrom_np
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "constant.h"
+#include "launch.h"
+
+extern char **environ;
+
+/**
+ * Move fd out of the fixed range so that the file actions can't overwrite it
+ * before it is duplicated => the fd to use, *moved set if it is a copy
+ */
+static int above_fixed(int fd, int *moved)
+{
+    *moved = 0;
+    if (fd == -1 || fd >= LAUNCH_FDS)
+        return fd;
+    int copy = fcntl(fd, F_DUPFD_CLOEXEC, LAUNCH_FDS);
+    if (copy == -1)
+        return fd;   // out of fds, the spawn itself will fail on it too
+    *moved = 1;
+    return copy;
+}
+
+pid_t launch_player(const char *path, const PlayerLaunch *pl, int effort_fd, int loc_fd,
+                    int shared_fd, int stats_fd, int quiet)
+{
+    // The block goes through a pipe: it is far below PIPE_BUF, so it is
+    // already waiting there when the player starts
+    int block_pipe[2];
+    if (pipe2(block_pipe, O_CLOEXEC) == -1) {
+        perror("pipe launch block failed");
+        return -1;
+    }
+    if (write(block_pipe[1], pl, sizeof(*pl)) != sizeof(*pl)) {
+        perror("write launch block failed");
+        close(block_pipe[0]);
+        close(block_pipe[1]);
+        return -1;
+    }
+    close(block_pipe[1]);
+
+    int src[LAUNCH_FDS] = { [0 ... LAUNCH_FDS - 1] = -1 };
+    int moved[LAUNCH_FDS] = { 0 };
+    src[LAUNCH_FD_BLOCK] = above_fixed(block_pipe[0], &moved[LAUNCH_FD_BLOCK]);
+    src[LAUNCH_FD_EFFORT] = above_fixed(effort_fd, &moved[LAUNCH_FD_EFFORT]);
+    src[LAUNCH_FD_LOC] = above_fixed(loc_fd, &moved[LAUNCH_FD_LOC]);
+    src[LAUNCH_FD_SHARED] = above_fixed(shared_fd, &moved[LAUNCH_FD_SHARED]);
+    src[LAUNCH_FD_STATS] = pl->has_stats ? above_fixed(stats_fd, &moved[LAUNCH_FD_STATS]) : -1;
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    for (int fd = LAUNCH_FD_BLOCK; fd < LAUNCH_FDS; fd++) {
+        if (src[fd] != -1)
+            posix_spawn_file_actions_adddup2(&fa, src[fd], fd);
+    }
+    if (quiet)
+        posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    // Nothing else of ours leaks in, whether it is close-on-exec or not
+    posix_spawn_file_actions_addclosefrom_np(&fa, LAUNCH_FDS);
+
+    // Our mask minus SIGCHLD, which the loop blocks for its signalfd. The
+    // referee's signals start out blocked: the player reads them from a
+    // signalfd, and one sent before it is set up waits there for it.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigprocmask(SIG_BLOCK, NULL, &mask);
+    sigdelset(&mask, SIGCHLD);
+    int player_signals[] = { SIG_ENERGY_REQ, SIG_SET_LOC, SIG_READY, SIG_PULL, SIG_STOP,
+                             SIG_RESET_ENERGY, SIG_TERMINATE };
+    for (int k = 0; k < (int)(sizeof(player_signals) / sizeof(player_signals[0])); k++)
+        sigaddset(&mask, player_signals[k]);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    pid_t pid;
+    char *argv[] = { (char *)path, NULL };
+    int err = posix_spawn(&pid, path, &fa, &attr, argv, environ);
+    posix_spawn_file_actions_destroy(&fa);
+    posix_spawnattr_destroy(&attr);
+
+    close(block_pipe[0]);
+    for (int fd = LAUNCH_FD_BLOCK; fd < LAUNCH_FDS; fd++) {
+        if (moved[fd])
+            close(src[fd]);
+    }
+    if (err != 0) {
+        fprintf(stderr, "posix_spawn %s failed: %s\n", path, strerror(err));
+        return -1;
+    }
+    return pid;
+}
+
+int launch_read(PlayerLaunch *pl)
+{
+    ssize_t n;
+    do {
+        n = read(LAUNCH_FD_BLOCK, pl, sizeof(*pl));
+    } while (n == -1 && errno == EINTR);
+    close(LAUNCH_FD_BLOCK);
+    if (n != sizeof(*pl) || pl->magic != LAUNCH_MAGIC || pl->size != sizeof(*pl))
+        return -1;
+    return 0;
+}
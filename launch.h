@@ -0,0 +1,44 @@
+// launch.h
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "player_logic.h"
+#include "tuning.h"
+
+// Player launch: ./player is started with posix_spawn (vfork semantics, no
+// copy of the referee's page tables) and gets exactly the fds below, at
+// fixed numbers; every other fd of the referee is closed in the child.
+// Its parameters arrive as one binary PlayerLaunch block on LAUNCH_FD_BLOCK.
+#define LAUNCH_FD_BLOCK   3   // read end of a pipe holding the PlayerLaunch
+#define LAUNCH_FD_EFFORT  4   // player -> referee effort pipe, write end
+#define LAUNCH_FD_LOC     5   // referee -> player location pipe, read end
+#define LAUNCH_FD_SHARED  6   // shared region (shm.h)
+#define LAUNCH_FD_STATS   7   // stats page (stats.h), if has_stats
+#define LAUNCH_FDS        8   // first fd the player doesn't get
+
+#define LAUNCH_MAGIC      0x524f5045u   // "ROPE"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;          // sizeof(PlayerLaunch), catches a stale binary
+    int id;                 // within the team
+    int team;
+    int energy;             // spawn state, player_spawn()
+    int decay_rate;
+    int has_stats;          // LAUNCH_FD_STATS is open
+    PlayerParams params;
+    Tuning tuning;          // applied by the player before it plays
+} PlayerLaunch;
+
+// Referee side: start player at path with pl and its pipe ends; shared_fd
+// and stats_fd (-1 => none) are the ones every player gets. quiet sends the
+// player's stdout to /dev/null. => pid, or -1
+pid_t launch_player(const char *path, const PlayerLaunch *pl, int effort_fd, int loc_fd,
+                    int shared_fd, int stats_fd, int quiet);
+
+// Player side: read our block from LAUNCH_FD_BLOCK => 0, or -1
+int launch_read(PlayerLaunch *pl);
+
+#endif
@@ -0,0 +1,151 @@
+// loop.c
+#include <stdio.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include "loop.h"
+
+#define MAX_LOOP_EVENTS 64
+
+long long mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int loop_init(EventLoop *lp)
+{
+    lp->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (lp->epfd == -1) {
+        perror("epoll_create1 failed");
+        return -1;
+    }
+
+    lp->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (lp->timer_fd == -1) {
+        perror("timerfd_create failed");
+        return -1;
+    }
+
+    // SIGCHLD must be blocked to be delivered through the signalfd
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+        perror("sigprocmask failed");
+        return -1;
+    }
+    lp->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (lp->signal_fd == -1) {
+        perror("signalfd failed");
+        return -1;
+    }
+
+    if (loop_watch(lp, lp->timer_fd, EPOLLIN, LOOP_TAG_TIMER) == -1 ||
+        loop_watch(lp, lp->signal_fd, EPOLLIN, LOOP_TAG_CHILD) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+int loop_watch(EventLoop *lp, int fd, unsigned int events, int tag)
+{
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.u64 = 0;
+    ev.data.fd = tag;
+    if (epoll_ctl(lp->epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        perror("epoll_ctl add failed");
+        return -1;
+    }
+    return 0;
+}
+
+int loop_unwatch(EventLoop *lp, int fd)
+{
+    return epoll_ctl(lp->epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+int loop_modify(EventLoop *lp, int fd, unsigned int events, int tag)
+{
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.u64 = 0;
+    ev.data.fd = tag;
+    if (epoll_ctl(lp->epfd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+        perror("epoll_ctl mod failed");
+        return -1;
+    }
+    return 0;
+}
+
+int loop_set_timer(EventLoop *lp, long long first_ns, long long period_ns)
+{
+    struct itimerspec its;
+    its.it_value.tv_sec = first_ns / 1000000000LL;
+    its.it_value.tv_nsec = first_ns % 1000000000LL;
+    its.it_interval.tv_sec = period_ns / 1000000000LL;
+    its.it_interval.tv_nsec = period_ns % 1000000000LL;
+    if (timerfd_settime(lp->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+        perror("timerfd_settime failed");
+        return -1;
+    }
+    // Drop expirations left over from a previous arming
+    loop_read_timer(lp);
+    return 0;
+}
+
+uint64_t loop_read_timer(EventLoop *lp)
+{
+    uint64_t expirations = 0;
+    if (read(lp->timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return 0;
+    return expirations;
+}
+
+int loop_wait(EventLoop *lp, LoopEvent *evs, int max, int timeout_ms)
+{
+    struct epoll_event ev[MAX_LOOP_EVENTS];
+    if (max > MAX_LOOP_EVENTS)
+        max = MAX_LOOP_EVENTS;
+
+    int n = epoll_wait(lp->epfd, ev, max, timeout_ms);
+    if (n == -1) {
+        if (errno == EINTR)
+            return 0;
+        perror("epoll_wait failed");
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        evs[i].tag = ev[i].data.fd;
+        evs[i].events = ev[i].events;
+        if (evs[i].tag == LOOP_TAG_CHILD) {
+            // Drain the pending SIGCHLD, the caller reaps with waitpid()
+            struct signalfd_siginfo si;
+            while (read(lp->signal_fd, &si, sizeof(si)) == sizeof(si))
+                ;
+        }
+    }
+    return n;
+}
+
+void loop_reset_child(void)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+}
+
+void loop_close(EventLoop *lp)
+{
+    close(lp->signal_fd);
+    close(lp->timer_fd);
+    close(lp->epfd);
+}
@@ -0,0 +1,50 @@
+// loop.h
+#ifndef LOOP_H
+#define LOOP_H
+
+#include <stdint.h>
+
+// Tags reported for the loop's own descriptors, caller fds use tags >= 0
+#define LOOP_TAG_TIMER  -1
+#define LOOP_TAG_CHILD  -2
+
+typedef struct {
+    int epfd;       // epoll instance
+    int timer_fd;   // tick timer (CLOCK_MONOTONIC, absolute deadlines)
+    int signal_fd;  // SIGCHLD => child exit notifications
+} EventLoop;
+
+typedef struct {
+    int tag;
+    unsigned int events;
+} LoopEvent;
+
+// Create the epoll instance, the tick timer and the SIGCHLD signalfd
+int loop_init(EventLoop *lp);
+
+// Watch fd for events (EPOLLIN, ...), reported with the given tag
+int loop_watch(EventLoop *lp, int fd, unsigned int events, int tag);
+int loop_unwatch(EventLoop *lp, int fd);
+
+// Change the events watched on fd
+int loop_modify(EventLoop *lp, int fd, unsigned int events, int tag);
+
+// Fire first at the absolute monotonic time first_ns, then every period_ns.
+// first_ns == 0 disarms the timer.
+int loop_set_timer(EventLoop *lp, long long first_ns, long long period_ns);
+
+// Number of timer expirations since the last call
+uint64_t loop_read_timer(EventLoop *lp);
+
+// Wait for up to max events, timeout_ms < 0 waits forever
+int loop_wait(EventLoop *lp, LoopEvent *evs, int max, int timeout_ms);
+
+// Restore the default signal mask in a freshly forked child
+void loop_reset_child(void);
+
+void loop_close(EventLoop *lp);
+
+// CLOCK_MONOTONIC in nanoseconds
+long long mono_ns(void);
+
+#endif
@@ -1,6 +1,10 @@
 /**
  * Rope Pulling Game - Main Process
  * Controls the game flow, manages child processes, and visualizes results
+ *
+ * The referee is built around a single epoll loop (loop.h) watching the tick
+ * timer, the effort pipes, the graphics pipe and child exits. Pauses between
+ * game phases are loop timeouts, so the referee keeps reacting while it waits.
  */
 
 #include <stdio.h>
@@ -8,208 +12,926 @@
 #include <unistd.h>
 #include <signal.h>
 #include <sys/wait.h>
+#include <sys/epoll.h>
 #include <time.h>
-#include <sys/time.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "constant.h"
 #include "config.h"
 #include "pipe.h"
+#include "shm.h"
+#include "game_state.h"
+#include "loop.h"
+#include "timing.h"
+#include "game_rules.h"
+#include "ranking.h"
+#include "sim.h"
+#include "player_thread.h"
+#include "replay_log.h"
+#include "stats.h"
+#include "rng.h"
+#include "launch.h"
+#include "telemetry.h"
+#include "tuning.h"
+
+// Phase pauses live in game_rules.h, shared with the virtual clock
+#define REPLY_TIMEOUT_MS    1000  // Stop waiting for missing energy replies
+
+
+#define TAG_GRAPHICS        -3    // loop tag of the graphics pipe, players use their index
+#define TAG_THREADS         -4    // loop tag of the player threads' reply queue
+#define TAG_CONFIG          -5    // loop tag of the config file watch
+#define TAG_DAEMON          -6    // loop tag of the --daemon socket
+
+#define SINK_DRAIN_MS       1000  // how long a slow sink may take to write its queue at exit
+
+#define RECORD_BATCH        32    // tick records taken from a player's pipe per readv()
+
+// Referee-side state of every player, one array per field, sized at startup
+// for num_teams * team_size players. Player i is member i % team_size of
+// team i / team_size, the same index as its shared-memory slot.
+typedef struct {
+    int count;                // num_teams * team_size
+    pid_t *pid;               // child PIDs
+    int *alive;               // cleared when the child exits
+    int *effort_fd;           // child->parent pipe, read end
+    int *loc_fd;              // parent->child pipe, write end
+    TickRecord *rx;           // partial record reassembly
+    int *rx_len;
+    unsigned int *next_seq;   // seq of the next record expected
+    int *replied;             // state report received since the last request
+    int *reports;             // last tick of this round reported
+    int *energy;              // raw energy of the last record
+    int *location;            // location of the last record
+    long long *req_ns;        // when the last state request went out
+    PlayerSlot *snap;         // last consistent snapshot of each slot (shm mode)
+} Roster;
 
 // Global variables for communication and process management
 static int graphics_pipe[2];        // parent->graphics pipe
 pid_t graphics_pid = -1;            // graphics child PID
+int graphics_alive = 0;             // graphics process still reading
+int graphics_dropped = 0;           // updates the pipe feed's queue let go
+Sink *graphics_sink = NULL;         // pipe feed: writer thread + queue (telemetry.h)
+Sink *json_sink = NULL;             // --json: a JSON line per update
+Sink *telemetry_sink = NULL;        // --telemetry: binary file of the updates
+GameState *game_state = NULL;       // latest-state page (graphics_feed shm)
+int game_state_fd = -1;             // its fd, inherited by graphics only
 
-int effort_pipes[MAX_PLAYERS][2];   // child->parent communication
-int loc_pipes[MAX_PLAYERS][2];      // parent->child communication
 int range_energy[2];                // Store range energy values
 
-pid_t players[MAX_PLAYERS];         // 8 child PIDs
+Roster roster;                      // per-player state
+int num_teams;                      // cfg.num_teams
+int team_size;                      // cfg.team_size
+Ranking *team_rank = NULL;          // location ranking of each team
+int *rank_keys = NULL;              // one team's energies, scratch
 GameConfig cfg;                     // config
+const char *config_path = NULL;     // watched, changes apply from the next round
+int config_watch_fd = -1;           // inotify on its directory
+int config_changed = 0;             // written since the last round started
+
+int daemon_fd = -1;                 // --daemon: listening socket
+int daemon_client = -1;             // connection whose game is next, -1 => none
+unsigned int game_seed;             // key of every random draw (rng.h)
+
+MatchScore match;                   // Scores and consecutive wins across rounds
+
+SharedState *shared = NULL;         // Round clock + player slots (shm mode)
+int shared_fd = -1;                 // fd of the shared region, inherited by players
+
+ReplayLog replay_log;               // --record: every input of the scoring
+
+StatsPage *stats = NULL;            // live counters, read by rope_stat
+int stats_fd = -1;                  // its fd, inherited by players
+
+EventLoop loop;                     // referee event loop
+int game_aborted = 0;               // a player died => end the game
+long long game_start_ns;            // monotonic start of the game
+long long first_tick_ns;            // when its first tick closed, 0 => not yet
+
+// State of the round in progress
+int round_active = 0;               // efforts only count while players pull
+int round_number = 0;
+int round_ticks = 0;                // ticks closed so far
+int round_deadlines = 0;            // tick deadlines reached so far
+int round_winner = -1;
+int team_sums[MAX_TEAMS];           // effort of each team this round
+int pending_reports = 0;            // live players yet to report the open tick
+GraphicsMessage *graphics_msg;      // sized for the configured teams
+
+// Tick clock: every process ticks at round_epoch_ns + k * tick_ns, the
+// referee closes tick k at that time + tick_grace_ns unless every player
+// reported earlier
+long long tick_ns;                  // tick period, 1e9 / tick_hz
+long long tick_grace_ns;            // how long reports of a tick are awaited
+long long round_epoch_ns;           // epoch of the round in progress
+
+// Tick timing, reported at the end of the game
+TimingStats deadline_lateness;      // referee wake-up vs. tick deadline
+TimingStats report_lateness;        // player effort arrival vs. its tick
+int ticks_early = 0;                // closed as soon as everyone reported
+int ticks_at_deadline = 0;          // closed by the deadline
+int stray_reports = 0;              // reports that missed their tick
+int stale_records = 0;              // records of another round, or repeated, dropped
+
+// Startup of the first game phase by phase, logged at its first SIG_PULL
+#define MAX_STARTUP_PHASES 8
+long long launch_ns;                // main() entered
+const char *startup_phase[MAX_STARTUP_PHASES];
+long long startup_end_ns[MAX_STARTUP_PHASES];
+int startup_count[MAX_STARTUP_PHASES]; // things started in it, 0 => not a count
+int startup_phases = 0;             // marked so far, -1 => logged
+
+/**
+ * The startup phase named phase ends now, after starting count things
+ */
+void startup_mark(const char *phase, int count) {
+    if (startup_phases < 0 || startup_phases == MAX_STARTUP_PHASES)
+        return;
+    startup_phase[startup_phases] = phase;
+    startup_count[startup_phases] = count;
+    startup_end_ns[startup_phases++] = mono_ns();
+}
+
+/**
+ * Log how long each startup phase took, once: the last one ends with the
+ * first SIG_PULL of the game
+ */
+void startup_report() {
+    if (startup_phases <= 0)
+        return;
+    printf("[PARENT] Startup:");
+    long long from = launch_ns;
+    for (int k = 0; k < startup_phases; k++) {
+        printf("%s %s %.1f ms", k ? "," : "", startup_phase[k], (startup_end_ns[k] - from) / 1e6);
+        if (startup_count[k] > 0)
+            printf(" (%.2f ms each)", (startup_end_ns[k] - from) / 1e6 / startup_count[k]);
+        from = startup_end_ns[k];
+    }
+    printf(" => first SIG_PULL %.1f ms after launch\n", (from - launch_ns) / 1e6);
+    fflush(stdout);
+    startup_phases = -1;
+}
 
-int team_scores[2] = {0, 0};        // Track team scores across rounds
-int consecutive_wins[2] = {0, 0};   // Track consecutive wins for end condition
+/**
+ * Allocate the per-player arrays for count players
+ */
+void roster_init(int count) {
+    roster.count = count;
+    roster.pid = calloc(count, sizeof(pid_t));
+    roster.alive = calloc(count, sizeof(int));
+    roster.effort_fd = calloc(count, sizeof(int));
+    roster.loc_fd = calloc(count, sizeof(int));
+    roster.rx = calloc(count, sizeof(TickRecord));
+    roster.rx_len = calloc(count, sizeof(int));
+    roster.next_seq = calloc(count, sizeof(unsigned int));
+    roster.replied = calloc(count, sizeof(int));
+    roster.reports = calloc(count, sizeof(int));
+    roster.energy = calloc(count, sizeof(int));
+    roster.location = calloc(count, sizeof(int));
+    roster.req_ns = calloc(count, sizeof(long long));
+    roster.snap = calloc(count, sizeof(PlayerSlot));
+    if (!roster.pid || !roster.alive || !roster.effort_fd || !roster.loc_fd ||
+        !roster.rx || !roster.rx_len || !roster.next_seq || !roster.replied ||
+        !roster.reports || !roster.energy || !roster.location || !roster.req_ns || !roster.snap) {
+        perror("roster allocation failed");
+        exit(1);
+    }
+}
+
+/**
+ * Print the per-team values as "Team1=a, Team2=b, ..."
+ */
+void print_team_values(const int values[]) {
+    for (int t = 0; t < num_teams; t++) {
+        printf("%sTeam%d=%d", t ? ", " : "", t + 1, values[t]);
+    }
+}
+
+/**
+ * The graphics process stopped reading
+ */
+void drop_graphics() {
+    if (graphics_alive) {
+        graphics_alive = 0;
+        if (cfg.graphics_feed == FEED_PIPE)
+            loop_unwatch(&loop, graphics_pipe[1]);
+    }
+}
 
 /**
- * Fork and execute the graphics process with pipe communication
+ * Date a state update and hand it to graphics and the telemetry sinks. Only
+ * a sink with the block policy may make the referee wait; the others drop
+ * updates when their consumer falls behind.
+ */
+void send_graphics(GraphicsMessage *msg) {
+    msg->stateNs = mono_ns();
+    msg->tickNs = tick_ns;
+    if (json_sink)
+        sink_push(json_sink, msg);
+    if (telemetry_sink)
+        sink_push(telemetry_sink, msg);
+    if (!graphics_alive)
+        return;
+    stat_inc(&stats->graphics_sent);
+    if (cfg.graphics_feed == FEED_SHM) {
+        // Overwrite the page, graphics picks up whatever is latest
+        if (game_state_publish(game_state, msg))
+            stat_inc(&stats->graphics_coalesced);
+        return;
+    }
+    int queued = sink_push(graphics_sink, msg);
+    if (queued == 1) {
+        graphics_dropped++;      // Graphics fell behind, an older update made room
+        stat_inc(&stats->graphics_dropped);
+    } else if (queued == -1) {
+        drop_graphics();         // Reader is gone
+    }
+}
+
+/**
+ * Start the --json and --telemetry sinks (NULL => not asked for) => 0, or -1
+ */
+int open_sinks(const char *json_path, const char *telemetry_path) {
+    const char *paths[] = { json_path, telemetry_path };
+    const SinkFormat *formats[] = { &sink_format_json, &sink_format_telemetry };
+    int policies[] = { cfg.json_policy, cfg.telemetry_policy };
+    Sink **sinks[] = { &json_sink, &telemetry_sink };
+    for (int k = 0; k < 2; k++) {
+        if (!paths[k])
+            continue;
+        int fd = open(paths[k], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            perror(paths[k]);
+            return -1;
+        }
+        *sinks[k] = sink_open(formats[k], fd, policies[k], cfg.sink_queue, num_teams, team_size);
+        if (!*sinks[k])
+            return -1;
+        printf("[PARENT] Writing %s updates to %s (%s)\n", formats[k]->name, paths[k],
+               sink_policy_name(policies[k]));
+    }
+    return 0;
+}
+
+/**
+ * Make room for needed file descriptors, up to the hard limit
+ */
+void raise_fd_limit(int needed) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == -1 || rl.rlim_cur >= (rlim_t)needed)
+        return;
+    rl.rlim_cur = (rl.rlim_max == RLIM_INFINITY || rl.rlim_max > (rlim_t)needed)
+                  ? (rlim_t)needed : rl.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &rl) == -1 || rl.rlim_cur < (rlim_t)needed)
+        fprintf(stderr, "[PARENT] Only %ld file descriptors for %d needed\n",
+                (long)rl.rlim_cur, needed);
+}
+
+/**
+ * Fork and execute the graphics process, fed through a pipe or through the
+ * shared GameState page
  */
 void fork_graphics_process() {
-    if (pipe(graphics_pipe) == -1) {
+    if (cfg.graphics_feed == FEED_SHM) {
+        game_state = game_state_create(num_teams, team_size, &game_state_fd);
+        if (!game_state)
+            exit(1);
+    } else if (pipe(graphics_pipe) == -1) {
         perror("graphics_pipe creation failed");
         exit(1);
     }
-    
+
     graphics_pid = fork();
-    
+
     if (graphics_pid == 0) {
         // Child: graphics process
-        close(graphics_pipe[1]); // Close write end, child only reads
-        
-        // Convert pipe read fd to string to pass as argument
-        char read_fd_str[16];
-        sprintf(read_fd_str, "%d", graphics_pipe[0]);
-        
-        execl("./graphics", "./graphics", read_fd_str, (char*)NULL);
+        loop_reset_child();
+
+        if (cfg.graphics_feed == FEED_SHM) {
+            // Keep the page across exec
+            fcntl(game_state_fd, F_SETFD, 0);
+            char shm_fd_str[16];
+            sprintf(shm_fd_str, "%d", game_state_fd);
+            execl("./graphics", "./graphics", "--shm", shm_fd_str, (char*)NULL);
+        } else {
+            close(graphics_pipe[1]); // Close write end, child only reads
+
+            // Convert pipe read fd to string to pass as argument
+            char read_fd_str[16];
+            sprintf(read_fd_str, "%d", graphics_pipe[0]);
+            execl("./graphics", "./graphics", read_fd_str, (char*)NULL);
+        }
         perror("execl graphics failed");
         exit(1);
     } else if (graphics_pid > 0) {
         printf("[PARENT] Spawned graphics process with PID %d\n", graphics_pid);
+        graphics_alive = 1;
+        if (cfg.graphics_feed == FEED_SHM)
+            return;
+
         close(graphics_pipe[0]); // Close read end, parent only writes
+
+        // A writer thread of its own feeds the pipe, so a slow renderer
+        // never blocks us; EPOLLERR tells us it went away
+        graphics_sink = sink_open(&sink_format_graphics, graphics_pipe[1], cfg.graphics_policy,
+                                  cfg.sink_queue, num_teams, team_size);
+        if (!graphics_sink)
+            exit(1);
+        loop_watch(&loop, graphics_pipe[1], 0, TAG_GRAPHICS);
     } else {
         perror("fork failed for graphics process");
         exit(1);
     }
 }
 
+/**
+ * Scheduling of the players (tuning.h), from the config
+ */
+Tuning player_tuning() {
+    Tuning t = { cfg.player_priority, cfg.player_cpus, cfg.lock_memory, cfg.prefault_stack_kb };
+    return t;
+}
+
 /**
  * Spawn player processes with configuration params
  */
 void spawn_players() {
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        // Create the location pipe too
-        if (pipe(loc_pipes[i]) == -1) {
+    for (int i = 0; i < roster.count; i++) {
+        // child->parent effort pipe and parent->child location pipe
+        int effort_pipe[2], loc_pipe[2];
+        if (pipe(effort_pipe) == -1) {
+            perror("pipe effort failed");
+            exit(1);
+        }
+        if (pipe(loc_pipe) == -1) {
             perror("pipe loc failed");
             exit(1);
         }
+        // None of these leak into other children, the player gets its ends
+        // through the launch file actions
+        for (int k = 0; k < 2; k++) {
+            fcntl(effort_pipe[k], F_SETFD, FD_CLOEXEC);
+            fcntl(loc_pipe[k], F_SETFD, FD_CLOEXEC);
+        }
 
-        int team_id = (i < TEAM_SIZE) ? TEAM1 : TEAM2;
-        int player_id = (team_id == TEAM1) ? i : i - TEAM_SIZE;
-
-        int init_energy = rand() % (cfg.energy_max - cfg.energy_min + 1) + cfg.energy_min;
-        int decay = rand() % (cfg.decay_max - cfg.decay_min + 1) + cfg.decay_min;
-
-        // Prepare command-line arguments for player process
-        char buf_id[16], buf_team[16], buf_decay[16], buf_energy[16];
-        char buf_write_effort[16], buf_read_loc[16];
-        char buf_decay_min[16], buf_decay_max[16], buf_recover_min[16], buf_recover_max[16];
-        char buf_max_energy[16], buf_min_energy[16];
-
-        sprintf(buf_id, "%d", player_id);
-        sprintf(buf_team, "%d", team_id);
-        sprintf(buf_decay, "%d", decay);
-        sprintf(buf_energy, "%d", init_energy);
-        // child->parent => effort_pipes[i][1]
-        sprintf(buf_write_effort, "%d", effort_pipes[i][1]);
-        // parent->child => loc_pipes[i][0] (child reads)
-        sprintf(buf_read_loc, "%d", loc_pipes[i][0]);
-        // decay_min/max and recover_min/max are passed to the child
-        sprintf(buf_decay_min, "%d", cfg.decay_min);
-        sprintf(buf_decay_max, "%d", cfg.decay_max);
-        sprintf(buf_recover_min, "%d", cfg.fall_recover_min);
-        sprintf(buf_recover_max, "%d", cfg.fall_recover_max);
-        sprintf(buf_max_energy, "%d", cfg.energy_max);
-        sprintf(buf_min_energy, "%d", cfg.energy_min);
-
-        pid_t pid = fork();
-        if (pid == 0) {
-            // Child
-            // Close parent's ends
-            close(effort_pipes[i][0]); // Child not reading from effort pipe
-            close(loc_pipes[i][1]);    // Child not writing to loc pipe
-
-            execl("./player", "./player",
-                buf_id,           // argv[1]
-                buf_team,         // argv[2]
-                buf_decay,        // argv[3]
-                buf_energy,       // argv[4]
-                buf_write_effort, // argv[5]
-                buf_read_loc,     // argv[6]
-                buf_decay_min,    // argv[7]
-                buf_decay_max,    // argv[8]
-                buf_recover_min,  // argv[9]
-                buf_recover_max,  // argv[10]
-                buf_max_energy,   // argv[11]
-                buf_min_energy,   // argv[12],
-                (char*)NULL);
-            perror("execl failed");
+        PlayerData start;
+        player_spawn(&start, &shared->params, game_seed, i);
+
+        PlayerLaunch pl = {
+            .magic = LAUNCH_MAGIC,
+            .size = sizeof(PlayerLaunch),
+            .id = i % team_size,
+            .team = i / team_size,
+            .energy = start.energy,
+            .decay_rate = start.decay_rate,
+            .has_stats = stats_fd != -1,
+            .params = shared->params,
+            .tuning = player_tuning(),
+        };
+        pid_t pid = launch_player("./player", &pl, effort_pipe[1], loc_pipe[0], shared_fd,
+                                  stats_fd, 0);
+        if (pid == -1) {
             exit(1);
-        } else {
-            players[i] = pid;
-            // Parent
-            close(effort_pipes[i][1]); // Parent won't write to child's effort pipe
-            close(loc_pipes[i][0]);    // Parent won't read from child's loc pipe
         }
+        roster.pid[i] = pid;
+        roster.alive[i] = 1;
+        close(effort_pipe[1]); // Parent won't write to child's effort pipe
+        close(loc_pipe[0]);    // Parent won't read from child's loc pipe
+        roster.effort_fd[i] = effort_pipe[0];
+        roster.loc_fd[i] = loc_pipe[1];
+
+        // The loop reads whatever the player has sent, never blocking
+        fcntl(effort_pipe[0], F_SETFL, fcntl(effort_pipe[0], F_GETFL) | O_NONBLOCK);
+        loop_watch(&loop, effort_pipe[0], EPOLLIN, i);
         range_energy[0] = cfg.energy_min; // Save initial energy
         range_energy[1] = cfg.energy_max;
     }
 }
 
 /**
- * Request raw energy from each child, gather replies, assign location
+ * Start the players as threads of this process (player_engine thread)
  */
-void assign_locations() {
-    // 1) Ask for energy
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        kill(players[i], SIG_ENERGY_REQ);
-    }
-
-    
-
-    // 2) read 8 replies (EnergyReply)
-    // We'll store them in arrays for Team1 & Team2
-    typedef struct { int id; int energy; } SimplePlayer;
-    SimplePlayer t1[TEAM_SIZE], t2[TEAM_SIZE];
-    int c1 = 0, c2 = 0;
-
-    int replies = 0;
-    while (replies < MAX_PLAYERS) {
-        EnergyReply er;
-        int got = read_effort(effort_pipes[replies][0], &er, sizeof(er));
-        if (got == sizeof(er)) {
-            if (er.team == TEAM1) {
-                t1[c1].id = er.player_id; // 0..3
-                t1[c1].energy = er.energy % 100;
-                printf("T1: %d %d\n", t1[c1].id, t1[c1].energy);
-                fflush(stdout);
-                c1++;
-            } else {
-                t2[c2].id = er.player_id; // 0..3
-                t2[c2].energy = er.energy % 100;
-                printf("T2: %d %d\n", t2[c2].id, t2[c2].energy);
-                fflush(stdout);
-                c2++;
+void spawn_player_threads() {
+    PlayerData *init = calloc(roster.count, sizeof(PlayerData));
+    if (!init) {
+        perror("calloc player threads failed");
+        exit(1);
+    }
+    for (int i = 0; i < roster.count; i++) {
+        PlayerData *pd = &init[i];
+        pd->team = i / team_size;
+        pd->id = i % team_size;
+        player_spawn(pd, &shared->params, game_seed, i);
+        roster.alive[i] = 1;
+    }
+
+    Tuning tuning = player_tuning();
+    tuning.lock_memory = 0;   // process-wide, the referee's tuning locks it
+    if (threads_start(init, roster.count, &shared->params, shared, stats->players,
+                      &tuning) != 0) {
+        exit(1);
+    }
+    free(init);
+    loop_watch(&loop, threads_fd(), EPOLLIN, TAG_THREADS);
+    printf("[PARENT] Started %d player threads\n", roster.count);
+}
+
+/**
+ * Deliver a SIG_* to player i, as a signal or as a thread command
+ */
+void signal_player(int i, int sig) {
+    stat_inc(&stats->referee.signals_sent);
+    if (cfg.player_engine == ENGINE_THREAD) {
+        threads_send(i, sig, 0);
+    } else {
+        kill(roster.pid[i], sig);
+    }
+}
+
+/**
+ * Send an assigned location to player i
+ */
+void send_location(int i, LocationMessage *lm) {
+    stat_inc(&stats->referee.signals_sent);
+    stat_inc(&stats->referee.messages_sent);
+    if (cfg.player_engine == ENGINE_THREAD) {
+        threads_send(i, SIG_SET_LOC, lm->location);
+    } else {
+        write_effort(roster.loc_fd[i], lm, sizeof(*lm));
+        kill(roster.pid[i], SIG_SET_LOC);
+    }
+}
+
+/**
+ * Ask one player for its raw energy, the state report arrives through the loop
+ */
+void request_energy(int i) {
+    roster.replied[i] = 0;
+    roster.req_ns[i] = mono_ns();
+    signal_player(i, SIG_ENERGY_REQ);
+}
+
+/**
+ * Shared-memory mode: snapshot every player's slot in one pass and sum
+ * the team efforts accumulated in the given round into team_sums. A slot
+ * that is busy or still holds the previous round keeps its last good
+ * snapshot.
+ */
+void read_player_slots(int round) {
+    for (int t = 0; t < num_teams; t++) {
+        team_sums[t] = 0;
+    }
+    for (int i = 0; i < roster.count; i++) {
+        PlayerSlot ps;
+        if (slot_read(&shared->slots[i], &ps) == 0 && ps.round == round) {
+            if (roster.snap[i].round != round || roster.snap[i].tick != ps.tick) {
+                replay_append(&replay_log, REC_SLOT, i, round, ps.tick, ps.effort_sum,
+                              ps.data.location, ps.data.energy);
+                if (cfg.dynamic_positions)
+                    ranking_update(&team_rank[i / team_size], i % team_size, ps.data.energy);
+            }
+            roster.snap[i] = ps;
+        }
+        if (roster.snap[i].round != round)
+            continue;
+        team_sums[i / team_size] += roster.snap[i].effort_sum;
+    }
+}
+
+/**
+ * Pipe mode: count the live players that still owe a report for the tick
+ * being collected
+ */
+void count_pending_reports() {
+    pending_reports = 0;
+    for (int i = 0; i < roster.count; i++) {
+        if (roster.alive[i] && roster.reports[i] <= round_ticks)
+            pending_reports++;
+    }
+}
+
+/**
+ * dynamic_positions: send a new location to every player the energies
+ * reported during the tick moved, and only to them
+ */
+void send_moved_locations() {
+    for (int t = 0; t < num_teams; t++) {
+        Ranking *r = &team_rank[t];
+        int moved = ranking_take_moved(r);
+        for (int k = 0; k < moved; k++) {
+            LocationMessage lm;
+            lm.player_id = r->moved[k];
+            lm.location = r->pos[lm.player_id];
+            send_location(t * team_size + lm.player_id, &lm);
+            replay_append(&replay_log, REC_LOCATION, t * team_size + lm.player_id,
+                          round_number, round_ticks, lm.location, 0, 0);
+        }
+    }
+}
+/**
+ * Close the current tick: report, update graphics, check round end
+ */
+void finish_tick() {
+    round_ticks++;
+    if (first_tick_ns == 0)
+        first_tick_ns = mono_ns();
+    stat_inc(&stats->referee.ticks);
+
+    if (cfg.ipc_mode == IPC_SHM) {
+        // One pass over the slots, no signals and no waiting
+        read_player_slots(round_number);
+        for (int i = 0; i < roster.count; i++) {
+            if (roster.snap[i].round == round_number && roster.snap[i].tick != round_ticks)
+                stray_reports++;
+        }
+    } else {
+        count_pending_reports();
+    }
+
+    printf("[Round %d, tick %d]", round_number, round_ticks);
+    for (int t = 0; t < num_teams; t++) {
+        printf("%s T%d=%d", t ? "," : "", t + 1, team_sums[t]);
+    }
+    printf("\n");
+
+    // Update the graphics state
+    int *energies = graphics_energies(graphics_msg);
+    for (int i = 0; i < roster.count; i++) {
+        int energy, location;
+        if (cfg.ipc_mode == IPC_SHM) {
+            if (roster.snap[i].round != round_number)
+                continue;
+            energy = roster.snap[i].data.energy;
+            location = roster.snap[i].data.location;
+        } else {
+            if (roster.reports[i] == 0)
+                continue;
+            energy = roster.energy[i];
+            location = roster.location[i];
+        }
+        energies[i] = energy / (location + 1);
+    }
+    memcpy(graphics_sums(graphics_msg), team_sums, num_teams * sizeof(int));
+    graphics_msg->tick = round_ticks;
+
+    // Send real-time updates to graphics
+    send_graphics(graphics_msg);
+
+    // Win threshold or game time limit (game_rules.c)
+    int time_up;
+    long elapsed = (mono_ns() - game_start_ns) / 1000000000LL;
+    round_winner = round_check(&cfg, team_sums, elapsed, &time_up);
+    replay_append(&replay_log, REC_TICK, -1, round_number, round_ticks, elapsed, round_winner, 0);
+    if (time_up) {
+        printf("Time limit => end\n");
+    }
+
+    // Moves take effect from the next tick on
+    if (cfg.dynamic_positions && round_winner < 0)
+        send_moved_locations();
+}
+
+/**
+ * Handle one tick record of player i. The record names its round and tick:
+ * one of another round, or of a tick already reported, is stale and dropped.
+ */
+void on_player_record(int i, const TickRecord *rec) {
+    stat_inc(&stats->referee.messages_received);
+    if (rec->seq < roster.next_seq[i]) {
+        stale_records++;   // sent before, can't count twice
+        return;
+    }
+    roster.next_seq[i] = rec->seq + 1;
+
+    if (rec->tick == 0) {
+        // State report, the answer to request_energy()
+        int bucket = stats_latency_bucket(mono_ns() - roster.req_ns[i]);
+        stat_inc(&stats->reply_latency[bucket]);
+        roster.energy[i] = rec->energy;
+        roster.location[i] = rec->location;
+        replay_append(&replay_log, REC_ENERGY, i, round_number, round_ticks, rec->energy,
+                      rec->location, 0);
+        roster.replied[i] = 1;
+        return;
+    }
+
+    // Late ticks of a round that is already over
+    if (!round_active)
+        return;
+    if (rec->round != round_number || rec->tick <= roster.reports[i]) {
+        stale_records++;
+        return;
+    }
+
+    // Lateness against the tick this report belongs to
+    long long late = mono_ns() - (round_epoch_ns + rec->tick * tick_ns);
+    timing_add(&report_lateness, late);
+    if (late > tick_grace_ns)
+        stray_reports++;
+
+    team_sums[i / team_size] += rec->weighted_effort;
+    replay_append(&replay_log, REC_EFFORT, i, round_number, round_ticks,
+                  rec->weighted_effort, rec->location, 0);
+    roster.energy[i] = rec->energy;
+    roster.location[i] = rec->location;
+    replay_append(&replay_log, REC_ENERGY, i, round_number, round_ticks, rec->energy,
+                  rec->location, 0);
+    if (cfg.dynamic_positions)
+        ranking_update(&team_rank[i / team_size], i % team_size, rec->energy);
+
+    // Owed the tick being collected, and now has it
+    if (roster.reports[i] <= round_ticks && rec->tick > round_ticks)
+        pending_reports--;
+    roster.reports[i] = rec->tick;
+    if (round_winner < 0 && pending_reports == 0) {
+        finish_tick();   // everyone reported before the deadline
+        ticks_early++;
+    }
+}
+
+/**
+ * Drain player i's effort pipe, a batch of records per readv(); a record
+ * split across reads is finished by the next one
+ */
+void on_player_readable(int i) {
+    TickRecord batch[RECORD_BATCH];
+    for (;;) {
+        int count;
+        int n = read_records(roster.effort_fd[i], &roster.rx[i], &roster.rx_len[i], batch,
+                             RECORD_BATCH, &count);
+        if (n <= 0) {
+            if (n == 0) {
+                // EOF: the player is gone, SIGCHLD does the bookkeeping
+                loop_unwatch(&loop, roster.effort_fd[i]);
             }
-            replies++;
+            return;
         }
+        if (roster.rx_len[i] != 0)
+            stat_inc(&stats->referee.short_reads);
+        for (int k = 0; k < count; k++)
+            on_player_record(i, &batch[k]);
+    }
+}
+
+/**
+ * Give the players the configured ranges; they take them at the next
+ * SIG_RESET_ENERGY
+ */
+void publish_player_params() {
+    PlayerParams pp = {
+        .energy_min = cfg.energy_min, .energy_max = cfg.energy_max,
+        .decay_min = cfg.decay_min, .decay_max = cfg.decay_max,
+        .recover_min = cfg.fall_recover_min, .recover_max = cfg.fall_recover_max
+    };
+    shared->params = pp;
+}
+
+/**
+ * Watch the config file for changes. Its directory is watched, so editors
+ * that write a new file and rename it over the old one are seen too. A
+ * watch on a previous config (daemon games) is dropped.
+ */
+void watch_config() {
+    if (config_watch_fd != -1) {
+        loop_unwatch(&loop, config_watch_fd);
+        close(config_watch_fd);
+        config_watch_fd = -1;
+    }
+
+    char dir[4096];
+    const char *slash = strrchr(config_path, '/');
+    if (slash)
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - config_path + 1), config_path);
+    else
+        snprintf(dir, sizeof(dir), ".");
+
+    config_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (config_watch_fd == -1 ||
+        inotify_add_watch(config_watch_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        perror("inotify on the config failed, it won't be reloaded");
+        if (config_watch_fd != -1)
+            close(config_watch_fd);
+        config_watch_fd = -1;
+        return;
     }
+    loop_watch(&loop, config_watch_fd, EPOLLIN, TAG_CONFIG);
+}
 
-    // 3) Sort each team by energy (highest to lowest)
-    for (int i = 0; i < TEAM_SIZE-1; i++) {
-        for (int j = i+1; j < TEAM_SIZE; j++) {
-            if (t1[i].energy < t1[j].energy) {
-                SimplePlayer tmp = t1[i]; 
-                t1[i] = t1[j]; 
-                t1[j] = tmp;
+/**
+ * Files written in the config's directory: note if the config was one
+ */
+void on_config_event() {
+    const char *slash = strrchr(config_path, '/');
+    const char *name = slash ? slash + 1 : config_path;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int n;
+    while ((n = read(config_watch_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            if (ev->len > 0 && strcmp(ev->name, name) == 0 && !config_changed) {
+                config_changed = 1;
+                printf("[PARENT] %s changed, it applies from the next round\n", config_path);
             }
-            if (t2[i].energy < t2[j].energy) {
-                SimplePlayer tmp = t2[i]; 
-                t2[i] = t2[j]; 
-                t2[j] = tmp;
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+}
+
+/**
+ * Daemon socket readable: take the connection if no request is pending
+ */
+void on_daemon_connection() {
+    int fd;
+    while ((fd = accept(daemon_fd, NULL, NULL)) != -1) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (daemon_client != -1) {
+            dprintf(fd, "error busy\n");
+            close(fd);
+            continue;
+        }
+        daemon_client = fd;
+    }
+}
+
+/**
+ * Take the changed config at the start of a round. A config that doesn't
+ * load is reported and the game goes on with the current one.
+ */
+void reload_config(int round) {
+    config_changed = 0;
+    GameConfig next = cfg;
+    if (load_config(config_path, &next) != 0) {
+        printf("[PARENT] Keeping the current config\n");
+        return;
+    }
+    int changed[CONFIG_LIVE_KEYS];
+    int n = config_reload(&cfg, &next, changed);
+    for (int k = 0; k < n; k++) {
+        int value = *config_live_value(&cfg, changed[k]);
+        printf("[PARENT] Round %d: %s = %d\n", round, config_live_name(changed[k]), value);
+        replay_append(&replay_log, REC_CONFIG, -1, round, 0, changed[k], value, 0);
+    }
+    publish_player_params();
+}
+
+/**
+ * Reap exited children; losing a player ends the game
+ */
+void reap_children() {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        if (pid == graphics_pid) {
+            printf("[PARENT] Graphics process exited\n");
+            drop_graphics();
+            continue;
+        }
+        for (int i = 0; i < roster.count; i++) {
+            if (roster.pid[i] == pid && roster.alive[i]) {
+                printf("[PARENT] Player process %d exited unexpectedly => end game\n", pid);
+                roster.alive[i] = 0;
+                game_aborted = 1;
             }
         }
     }
-    
-    usleep(10000); // Let them process the energy message
-    
-    // 4) Assign location based on energy (highest energy gets location 0)
-    // then send location to each child via loc_pipes
-    for (int i = 0; i < TEAM_SIZE; i++) {
-        // For Team1
-        LocationMessage lm1;
-        lm1.player_id = t1[i].id;
-        lm1.location = i;  // 0..3
-        // We'll compute the parent's "index" in players[] for that child. If T1 => same
-        int pipe_idx1 = t1[i].id;   // if T1 is i => 0..3
-        write_effort(loc_pipes[pipe_idx1][1], &lm1, sizeof(lm1));
-        kill(players[pipe_idx1], SIG_SET_LOC);
+}
+
+/**
+ * Dispatch one event reported by the loop
+ */
+void dispatch(const LoopEvent *ev) {
+    if (ev->tag == LOOP_TAG_TIMER) {
+        uint64_t expired = loop_read_timer(&loop);
+        if (!round_active || expired == 0)
+            return;
+
+        round_deadlines += expired;
+        if (expired > 1)
+            stat_add(&stats->referee.tick_overruns, expired - 1);
+        long long due = round_epoch_ns + round_deadlines * tick_ns + tick_grace_ns;
+        timing_add(&deadline_lateness, mono_ns() - due);
+
+        // Close every tick whose deadline has passed with whatever arrived
+        while (round_winner < 0 && round_ticks < round_deadlines) {
+            finish_tick();
+            ticks_at_deadline++;
+        }
+    } else if (ev->tag == LOOP_TAG_CHILD) {
+        reap_children();
+    } else if (ev->tag == TAG_GRAPHICS) {
+        if (ev->events & (EPOLLERR | EPOLLHUP))
+            drop_graphics();     // Read end closed
+    } else if (ev->tag == TAG_CONFIG) {
+        on_config_event();
+    } else if (ev->tag == TAG_DAEMON) {
+        on_daemon_connection();
+    } else if (ev->tag == TAG_THREADS) {
+        // Player threads: same records as the pipes, already framed
+        ThreadReply replies[RECORD_BATCH];
+        int n;
+        while ((n = threads_drain(replies, RECORD_BATCH)) > 0) {
+            for (int k = 0; k < n; k++)
+                on_player_record(replies[k].index, &replies[k].rec);
+        }
+    } else if (ev->tag >= 0 && ev->tag < roster.count) {
+        on_player_readable(ev->tag);
+    }
+}
+
+/**
+ * Run the event loop until done() returns true or timeout_ms elapses
+ * (timeout_ms < 0 => no timeout)
+ */
+void run_loop(int timeout_ms, int (*done)(void)) {
+    long long deadline = timeout_ms < 0 ? -1 : mono_ns() + timeout_ms * 1000000LL;
+
+    while (!(done && done())) {
+        int wait_ms = -1;
+        if (deadline >= 0) {
+            long long left = deadline - mono_ns();
+            if (left <= 0)
+                break;
+            wait_ms = (left + 999999) / 1000000;
+        }
+
+        LoopEvent ev[16];
+        int n = loop_wait(&loop, ev, 16, wait_ms);
+        if (n < 0) {
+            game_aborted = 1;
+            break;
+        }
+        for (int k = 0; k < n; k++) {
+            dispatch(&ev[k]);
+        }
+    }
+}
+
+/**
+ * Loop exit conditions
+ */
+int all_replied() {
+    if (game_aborted)
+        return 1;
+    for (int i = 0; i < roster.count; i++) {
+        if (roster.alive[i] && !roster.replied[i])
+            return 0;
+    }
+    return 1;
+}
+
+int round_decided() {
+    return round_winner >= 0 || game_aborted;
+}
+
+int daemon_request_waiting() {
+    return daemon_client != -1 || game_aborted;
+}
+
+/**
+ * Request raw energy from each child, gather replies, assign location
+ */
+void assign_locations() {
+    // 1) Ask for energy
+    for (int i = 0; i < roster.count; i++) {
+        request_energy(i);
+    }
+
+    // 2) Let the loop collect the state reports (TickRecord, tick 0)
+    run_loop(REPLY_TIMEOUT_MS, all_replied);
+
+    for (int t = 0; t < num_teams; t++) {
+        // 3) Sort the team by energy (highest to lowest), players that did
+        // not reply go last and get no location
+        int c = 0;
+        for (int id = 0; id < team_size; id++) {
+            int i = t * team_size + id;
+            rank_keys[id] = -1;
+            if (!roster.replied[i])
+                continue;
+            rank_keys[id] = roster.energy[i];
+            printf("T%d: %d %d\n", t + 1, id, rank_keys[id]);
+            fflush(stdout);
+            c++;
+        }
+        ranking_build(&team_rank[t], rank_keys);
 
-        // For Team2
-        LocationMessage lm2;
-        lm2.player_id = t2[i].id;   // 0..3
-        lm2.location = i; 
-        int pipe_idx2 = t2[i].id + TEAM_SIZE; // if T2 => child index is 4..7
-        write_effort(loc_pipes[pipe_idx2][1], &lm2, sizeof(lm2));
-        kill(players[pipe_idx2], SIG_SET_LOC);
+        // 4) Assign location based on energy (highest energy gets location 0)
+        // then send location to each child via its location pipe
+        for (int k = 0; k < c; k++) {
+            LocationMessage lm;
+            lm.player_id = team_rank[t].order[k];
+            lm.location = k;
+            send_location(t * team_size + lm.player_id, &lm);
+            replay_append(&replay_log, REC_LOCATION, t * team_size + lm.player_id,
+                          round_number, 0, k, 0, 0);
+        }
     }
 }
 
@@ -217,43 +939,167 @@ void assign_locations() {
  * Reset all players' energy to a random value within configured range
  */
 void reset_players_energy() {
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        kill(players[i], SIG_RESET_ENERGY);
+    for (int i = 0; i < roster.count; i++) {
+        signal_player(i, SIG_RESET_ENERGY);
     }
 }
 
 /**
- * Main function - initialize game and manage rounds
+ * Play one round and return the winning team
  */
-int main(int argc, char *argv[])
-{
-    srand(time(NULL));
+int play_round(int round) {
+    if (config_changed)
+        reload_config(round);
+    reset_players_energy();
+    assign_locations();
 
-    // Check command line arguments
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <config_file>\n", argv[0]);
-        return 1;
+    run_loop(RESET_SETTLE_MS, NULL); // Let players process reset
+
+    // Signal players they are ready
+    for (int i = 0; i < roster.count; i++) {
+        signal_player(i, SIG_READY);
     }
+    run_loop(READY_DELAY_MS, NULL);
+    printf("=== Players are ready ===\n");
 
-    // Load configuration
-    if (load_config(argv[1], &cfg) != 0) {
-        return 1;
+    // Track round state
+    round_number = round;
+    round_ticks = 0;
+    round_deadlines = 0;
+    round_winner = -1;
+    for (int t = 0; t < num_teams; t++) {
+        team_sums[t] = 0;
+    }
+    for (int i = 0; i < roster.count; i++) {
+        roster.reports[i] = 0;
     }
+    count_pending_reports();
 
-    // Create the child->parent effort pipes
-    if (init_pipes(effort_pipes, MAX_PLAYERS) < 0) {
-        return 1;
+    // Initialize message to graphics, ticks may close from the first SIG_PULL on
+    memset(graphics_msg, 0, GRAPHICS_MSG_SIZE(num_teams, team_size));
+    graphics_msg->roundNumber = round;
+    graphics_msg->numTeams = num_teams;
+    graphics_msg->teamSize = team_size;
+    graphics_msg->roundWinner = 0; // No winner yet
+
+    // Send initial round information to graphics
+    send_graphics(graphics_msg);
+
+    // Publish the round clock, then signal players to start pulling
+    round_epoch_ns = mono_ns();
+    atomic_store(&shared->epoch_ns, round_epoch_ns);
+    atomic_store(&shared->round, round);
+    round_active = 1;
+    atomic_store(&stats->round, round);
+    replay_append(&replay_log, REC_ROUND_START, -1, round, 0, 0, 0, 0);
+    for (int i = 0; i < roster.count; i++) {
+        signal_player(i, SIG_PULL);
     }
+    startup_mark("reset and ready", 0);
+    startup_report();
+    // Tick deadlines are absolute, so they don't drift with loop latency
+    loop_set_timer(&loop, round_epoch_ns + tick_ns + tick_grace_ns, tick_ns);
+
+    run_loop(PULL_SETTLE_MS, NULL);
+    printf("=== Players are pulling ===\n");
+    fflush(stdout);
+
+    // Ticks are closed by the loop until the round is decided
+    run_loop(-1, round_decided);
+    loop_set_timer(&loop, 0, 0);
+    round_active = 0;
+
+    // Handle tie-break if the loop ended without a decision
+    if (round_winner < 0) {
+        round_winner = leading_team(team_sums, num_teams);
+    }
+    if (round_winner < 0) {
+        // Random winner among the tied leaders
+        int best = team_sums[0];
+        for (int t = 1; t < num_teams; t++) {
+            if (team_sums[t] > best)
+                best = team_sums[t];
+        }
+        int tied[MAX_TEAMS], n_tied = 0;
+        for (int t = 0; t < num_teams; t++) {
+            if (team_sums[t] == best)
+                tied[n_tied++] = t;
+        }
+        uint32_t draw[4];
+        rng_block(rng_key(game_seed, RNG_REFEREE), RNG_TIEBREAK, round, 0, draw);
+        round_winner = tied[rng_range(draw[0], 0, n_tied - 1)];
+    }
+
+    printf("=== Winner of round %d is Team %d ===\n", round, round_winner + 1);
+
+    // Update and send final round winner info to graphics
+    graphics_msg->roundWinner = round_winner + 1; // Convert to 1-based for display
+    graphics_msg->tick = round_ticks;
+    send_graphics(graphics_msg);
+
+    // Stop all players from pulling
+    for (int i = 0; i < roster.count; i++) {
+        signal_player(i, SIG_STOP);
+    }
+
+    // Late effort messages are drained and dropped meanwhile
+    run_loop(STOP_SETTLE_MS, NULL);
 
-    fork_graphics_process();  // Start graphics process
-    
-    // Spawn player processes
-    spawn_players();
-    usleep(10000);
-    
+    return round_winner;
+}
+
+/**
+ * Headless virtual-clock mode: play games back to back in this process,
+ * as fast as the CPU allows
+ */
+int run_virtual_games(int games, unsigned int seed) {
+    int wins[MAX_TEAMS + 1] = {0};   // ties, then one entry per team
+    long long rounds = 0, ticks = 0, virtual_ns = 0;
+
+    long long wall_start = mono_ns();
+    for (int g = 0; g < games; g++) {
+        SimResult res;
+        sim_run_game(&cfg, seed + g, &res);
+        wins[res.winner]++;
+        rounds += res.rounds;
+        ticks += res.ticks;
+        virtual_ns += res.virtual_ns;
+
+        if (games == 1) {
+            printf("\n==== Final Score ====\n");
+            print_team_values(res.team_scores);
+            printf(" (rounds=%d, ticks=%d, virtual time=%.1fs)\n",
+                   res.rounds, res.ticks, res.virtual_ns / 1e9);
+        }
+    }
+    double wall = (mono_ns() - wall_start) / 1e9;
+
+    printf("\n==== Virtual-clock summary (seed=%u) ====\n", seed);
+    printf("Games=%d", games);
+    for (int t = 0; t < num_teams; t++) {
+        printf(" Team%d wins=%d", t + 1, wins[t + 1]);
+    }
+    printf(" ties=%d\n", wins[0]);
+    printf("Avg rounds=%.2f avg ticks=%.2f avg virtual time=%.1fs\n",
+           (double)rounds / games, (double)ticks / games, virtual_ns / 1e9 / games);
+    printf("Wall time=%.3fs (%.0f games/s)\n", wall, wall > 0 ? games / wall : 0.0);
+    return 0;
+}
+
+/**
+ * Play one game with the players already running => the winner (0 => tie,
+ * t => Team t), or -1 if the recording can't start
+ */
+int play_game(const char *record_path) {
     // Time tracking for game duration
-    struct timeval start_time, current_time;
-    gettimeofday(&start_time, NULL);
+    game_start_ns = mono_ns();
+    first_tick_ns = 0;
+    if (record_path) {
+        if (replay_open(&replay_log, record_path, &cfg, game_seed) != 0)
+            return -1;
+        printf("[PARENT] Recording the game to %s\n", record_path);
+    }
+    replay_append(&replay_log, REC_GAME_START, -1, 0, 0, roster.count, 0, 0);
 
     // Initial location assignment
     printf("=== Assigning locations ===\n");
@@ -262,243 +1108,467 @@ int main(int argc, char *argv[])
     printf("=== Locations assigned ===\n");
     fflush(stdout);
 
-    usleep(100000); // Let players process the location message
-
+    run_loop(LOCATION_SETTLE_MS, NULL); // Let players process the location message
+    startup_mark("locations", 0);
 
     // Main game loop - run rounds until end condition
     int total_rounds = 0;
-    int last_winner = -1;
-    
-    while (1) {
+    match_init(&match, num_teams);
+
+    while (!game_aborted) {
         total_rounds++;
         printf("\n===== START ROUND %d =====\n", total_rounds);
-        
-        reset_players_energy();
-        assign_locations();
-        
-        usleep(100000); // Let players process reset
-        
-        // Signal players they are ready
-        for (int i = 0; i < MAX_PLAYERS; i++) {
-            kill(players[i], SIG_READY);
-        }
-        usleep(1000000); // Let them process the ready message
-        printf("=== Players are ready ===\n");
-        
-        // Signal players to start pulling
-        for (int i = 0; i < MAX_PLAYERS; i++) {
-            kill(players[i], SIG_PULL);
-        }
-        usleep(10000); // Let them process the pull message
-
-        printf("=== Players are pulling ===\n");     
-        fflush(stdout);
-        
-        // Track round state
-        int round_winner = -1;
-        int sum_t1 = 0, sum_t2 = 0;
-
-        // Gather energy information for display
-        typedef struct { int id; int energy; int location; } SimplePlayer;
-        SimplePlayer t1[TEAM_SIZE], t2[TEAM_SIZE];
-        int c1 = 0, c2 = 0;
-        
-        // Initialize message to graphics
-        GraphicsMessage graphics_msg;
-        memset(&graphics_msg, 0, sizeof(graphics_msg));
-        graphics_msg.roundNumber = total_rounds;
-        graphics_msg.roundWinner = 0; // No winner yet
-
-        // Send initial round information to graphics
-        write(graphics_pipe[1], &graphics_msg, sizeof(graphics_msg));
-
-        // Round simulation loop
-        sum_t1 = 0;
-        sum_t2 = 0;
-        
-        for (int t = 0; ; t++) {
-            sleep(1);
-            
-            // Request energy from all players first
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                kill(players[i], SIG_ENERGY_REQ);
-            }
-            
-            // Short delay to allow players to respond
-            usleep(10000);
-            
-            // Collect energy data for display
-            c1 = 0;
-            c2 = 0;
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                EnergyReply er;
-                int got = read_effort(effort_pipes[i][0], &er, sizeof(er));
-                if (got == sizeof(er)) {
-                    if (er.team == TEAM1) {
-                        t1[c1].id = er.player_id;
-                        t1[c1].energy = er.energy;
-                        t1[c1].location = er.location;
-                        
-                        c1++;
-                    } else {
-                        t2[c2].id = er.player_id;
-                        t2[c2].energy = er.energy;
-                        t2[c2].location = er.location;
-                        
-                        c2++;
-                    }
-                }
-            }
-            
-            // Read effort messages for round scoring
-            EffortMessage em;
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                int n = read_effort(effort_pipes[i][0], &em, sizeof(em));
-                if (n == sizeof(em)) {
-                    if (em.team == TEAM1) {
-                        sum_t1 += em.weighted_effort;
-                    } else {
-                        sum_t2 += em.weighted_effort;
-                    }
-                }
-            }
-            
-            printf("[Round %d, sec %d] T1=%d, T2=%d\n", total_rounds, t+1, sum_t1, sum_t2);
-
-             // Update the graphics state
-             for (int i = 0; i < TEAM_SIZE; i++) {
-                if (i < c1) {
-                    graphics_msg.team1Energies[t1[i].id] = t1[i].energy / (t1[i].location + 1);
-                }
-                if (i < c2) {
-                    graphics_msg.team2Energies[t2[i].id] = t2[i].energy / (t2[i].location + 1);
-                }
-            }
-            
-            graphics_msg.team1EffortSum = sum_t1;
-            graphics_msg.team2EffortSum = sum_t2;
-            
-            // Send real-time updates to graphics
-            write(graphics_pipe[1], &graphics_msg, sizeof(graphics_msg));
-
-            // Check if either team has reached the win threshold
-            if (sum_t1 >= cfg.win_threshold || sum_t2 >= cfg.win_threshold) {
-                round_winner = (sum_t1 > sum_t2) ? TEAM1 : TEAM2;
-                break;
-            }
 
-            // Check if game time limit is reached
-            gettimeofday(&current_time, NULL);
-            long elapsed = current_time.tv_sec - start_time.tv_sec;
-            if (elapsed >= cfg.max_game_time) {
-                printf("Time limit => end\n");
-                round_winner = (sum_t1 > sum_t2) ? TEAM1 : TEAM2;
-                break;
-            }
-        }
-        
-        // Handle tie-break if needed
-        if (round_winner < 0) {
-            int sum_t1 = 0, sum_t2 = 0;
-            EffortMessage em;
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                int n = read_effort(effort_pipes[i][0], &em, sizeof(em));
-                if (n == sizeof(em)) {
-                    if (em.team == TEAM1) {
-                        sum_t1 += em.weighted_effort;
-                    } else {
-                        sum_t2 += em.weighted_effort;
-                    }
-                }
-            }
-            if (sum_t1 > sum_t2) {
-                round_winner = TEAM1;
-            } else if (sum_t2 > sum_t1) {
-                round_winner = TEAM2;
-            } else {
-                round_winner = (rand() % 2); // Random winner if still tied
-            }
-        }
-
-        printf("=== Winner of round %d is Team %d ===\n", total_rounds, round_winner + 1);
-
-        // Update and send final round winner info to graphics
-        graphics_msg.roundWinner = round_winner + 1; // Convert to 1-based for display
-        write(graphics_pipe[1], &graphics_msg, sizeof(graphics_msg));
-
-        // Stop all players from pulling
-        for (int i = 0; i < MAX_PLAYERS; i++) {
-            kill(players[i], SIG_STOP);
+        int round_winner = play_round(total_rounds);
+        if (game_aborted) {
+            break;
         }
-                
-        // Add a delay to ensure players exit the pulling loop
-        usleep(100000); // 100ms delay
 
         // Update scoring logic
-        team_scores[round_winner]++;
-        if (round_winner == last_winner) {
-            consecutive_wins[round_winner]++;
-        } else {
-            consecutive_wins[TEAM1] = 0;
-            consecutive_wins[TEAM2] = 0;
-            consecutive_wins[round_winner] = 1;
-        }
-        last_winner = round_winner;
+        match_record(&match, round_winner);
 
         // Give time to view the results before next round
-        sleep(2);
+        run_loop(RESULT_PAUSE_MS, NULL);
 
         // Check end conditions
-        if (team_scores[TEAM1] >= cfg.max_score || team_scores[TEAM2] >= cfg.max_score) {
+        long elapsed = (mono_ns() - game_start_ns) / 1000000000LL;
+        int end_reason = match_check(&match, &cfg, round_winner, elapsed);
+        replay_append(&replay_log, REC_ROUND_END, -1, total_rounds, 0, round_winner,
+                      end_reason, elapsed);
+        if (end_reason == END_MAX_SCORE) {
             printf("Team %d reached max_score => end game.\n", round_winner+1);
             break;
         }
-        if (consecutive_wins[round_winner] >= cfg.consecutive_wins) {
-            printf("Team %d got %d consecutive wins => end\n", 
-                  round_winner+1, consecutive_wins[round_winner]);
+        if (end_reason == END_CONSECUTIVE) {
+            printf("Team %d got %d consecutive wins => end\n",
+                  round_winner+1, match.consecutive_wins[round_winner]);
             break;
         }
-        gettimeofday(&current_time, NULL);
-        long elapsed = current_time.tv_sec - start_time.tv_sec;
-        if (elapsed >= cfg.max_game_time) {
+        if (end_reason == END_TIME_LIMIT) {
             printf("Time limit => end\n");
             break;
         }
     }
 
     // Determine overall game winner
-    int game_winner = (team_scores[TEAM1] > team_scores[TEAM2]) ? 1 : 
-                     (team_scores[TEAM2] > team_scores[TEAM1]) ? 2 : 0; // 0 = tie
-    
-    // Send final game result to graphics
-    GraphicsMessage final_msg;
-    memset(&final_msg, 0, sizeof(final_msg));
-    final_msg.roundNumber = -1; // Signal this is final game message, not a round
-    final_msg.team1EffortSum = team_scores[TEAM1];
-    final_msg.team2EffortSum = team_scores[TEAM2];
-    final_msg.roundWinner = game_winner;
-    
+    int game_winner = match_winner(&match); // 0 = tie
+    replay_append(&replay_log, REC_GAME_END, -1, total_rounds, 0, game_winner, 0, 0);
+    replay_close(&replay_log);
+
+    // Send final game result to graphics, the team scores take the place
+    // of the effort sums
+    GraphicsMessage *final_msg = graphics_msg;
+    memset(final_msg, 0, GRAPHICS_MSG_SIZE(num_teams, 0));
+    final_msg->roundNumber = -1; // Signal this is final game message, not a round
+    final_msg->numTeams = num_teams;
+    final_msg->teamSize = 0;
+    final_msg->roundWinner = game_winner;
+    memcpy(graphics_sums(final_msg), match.team_scores, num_teams * sizeof(int));
+
     // Write the final game results
-    write(graphics_pipe[1], &final_msg, sizeof(final_msg));
-    
+    send_graphics(final_msg);
+
     // Give graphics time to process
-    sleep(1);
-    
-    // Close the pipe to signal end of data
-    close(graphics_pipe[1]);
-    
+    run_loop(FINAL_PAUSE_MS, NULL);
+    return game_winner;
+}
+
+/**
+ * Final score and tick clock quality of the game just played
+ */
+void print_game_results() {
+    // Print final game results
+    printf("\n==== Final Score ====\n");
+    print_team_values(match.team_scores);
+    printf("\n");
+    if (graphics_dropped > 0)
+        printf("Graphics updates dropped: %d\n", graphics_dropped);
+
+    // Tick clock quality: drift is the mean lateness, jitter its deviation
+    printf("\n==== Tick timing (tick_hz=%d) ====\n", cfg.tick_hz);
+    timing_print("Referee deadline lateness", &deadline_lateness);
+    if (cfg.ipc_mode == IPC_PIPE)
+        timing_print("Player report lateness", &report_lateness);
+    timing_print_hist("Referee deadline lateness", &deadline_lateness);
+    if (cfg.ipc_mode == IPC_PIPE)
+        timing_print_hist("Player report lateness", &report_lateness);
+    printf("Ticks closed early=%d, at deadline=%d, reports outside their tick=%d\n",
+           ticks_early, ticks_at_deadline, stray_reports);
+    if (stale_records > 0)
+        printf("Stale tick records dropped: %d\n", stale_records);
+}
+
+/**
+ * End of the session: graphics and the players go away
+ */
+void stop_processes() {
+    // Let the sinks write what they still hold; closing the pipe tells
+    // graphics there is no more data
+    Sink **sinks[] = { &graphics_sink, &json_sink, &telemetry_sink };
+    for (int k = 0; k < 3; k++) {
+        if (*sinks[k]) {
+            sink_close(*sinks[k], SINK_DRAIN_MS);
+            sink_print(*sinks[k]);
+            sink_free(*sinks[k]);
+            *sinks[k] = NULL;
+        }
+    }
+
     // Terminate player processes
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        kill(players[i], SIG_TERMINATE);
+    if (cfg.player_engine == ENGINE_THREAD) {
+        threads_stop();
+    } else {
+        for (int i = 0; i < roster.count; i++) {
+            if (roster.alive[i])
+                kill(roster.pid[i], SIG_TERMINATE);
+        }
+        for (int i = 0; i < roster.count; i++) {
+            if (roster.alive[i])
+                waitpid(roster.pid[i], NULL, 0);
+        }
+    }
+    loop_close(&loop);
+}
+
+/**
+ * Daemon: another game with the warm players. They take the new seed and
+ * ranges at SIG_RESET_ENERGY and go back to where fresh players of this
+ * game would start, so the game plays as `rope_game --seed` would.
+ */
+void start_next_game(unsigned int seed) {
+    game_seed = seed;
+    shared->game_seed = seed;
+    publish_player_params();
+    atomic_fetch_add(&shared->game, 1);
+    reset_players_energy();
+    run_loop(RESET_SETTLE_MS, NULL);
+
+    // And our own counters of a game
+    memset(&deadline_lateness, 0, sizeof(deadline_lateness));
+    memset(&report_lateness, 0, sizeof(report_lateness));
+    ticks_early = ticks_at_deadline = stray_reports = stale_records = 0;
+    graphics_dropped = 0;
+}
+
+/**
+ * Read the request line of the daemon client => its length, or -1
+ */
+int read_request(char *line, int size) {
+    struct timeval tv = { .tv_sec = 1 };
+    setsockopt(daemon_client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int len = 0;
+    while (len < size - 1) {
+        int n = read(daemon_client, line + len, 1);
+        if (n <= 0)
+            return -1;
+        if (line[len] == '\n')
+            break;
+        len++;
     }
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        wait(NULL);
+    line[len] = '\0';
+    return len;
+}
+
+/**
+ * "start <config_file> [seed]" => 0 with path (and seed, if given) set, or
+ * -1 if the line is anything else, trailing text included
+ */
+int parse_start(const char *line, char *path, unsigned int *seed) {
+    int end_path = -1, end_seed = -1;
+    int fields = sscanf(line, "start %4095s%n %u%n", path, &end_path, seed, &end_seed);
+    int end = fields == 2 ? end_seed : end_path;
+    if (fields < 1 || end < 0)
+        return -1;
+    end += strspn(line + end, " \t\r");
+    return line[end] == '\0' ? 0 : -1;
+}
+
+/**
+ * --daemon: keep the players and graphics and play a game for every
+ * "start <config_file> [seed]" line sent to the socket, until "stop".
+ * Every game needs a config of the same shape as the one we started with.
+ */
+int serve_games(const char *socket_path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return -1;
     }
-    
-    // Print final game results
-    printf("\n==== Final Score ====\n");
-    printf("Team1=%d, Team2=%d\n", team_scores[TEAM1], team_scores[TEAM2]);
+    strcpy(addr.sun_path, socket_path);
+    daemon_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socket_path);
+    if (daemon_fd == -1 || bind(daemon_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+        listen(daemon_fd, 8) == -1) {
+        perror("daemon socket failed");
+        return -1;
+    }
+    loop_watch(&loop, daemon_fd, EPOLLIN, TAG_DAEMON);
+    printf("[DAEMON] Waiting for games on %s\n", socket_path);
+    fflush(stdout);
+
+    int games = 0;
+    char *game_config = strdup(config_path);
+    while (!game_aborted) {
+        run_loop(-1, daemon_request_waiting);
+        if (game_aborted)
+            break;
+
+        long long request_ns = mono_ns();
+        char line[4096], path[4096];
+        unsigned int seed = game_seed + 1;
+        if (read_request(line, sizeof(line)) < 0 ||
+            (strcmp(line, "stop") != 0 && parse_start(line, path, &seed) != 0)) {
+            dprintf(daemon_client, "error expected: start <config_file> [seed] | stop\n");
+            close(daemon_client);
+            daemon_client = -1;
+            continue;
+        }
+        if (strcmp(line, "stop") == 0) {
+            dprintf(daemon_client, "stopped after %d games\n", games);
+            close(daemon_client);
+            daemon_client = -1;
+            break;
+        }
+
+        GameConfig next = cfg;
+        if (load_config(path, &next) != 0 || !config_same_shape(&cfg, &next)) {
+            dprintf(daemon_client, "error %s does not load or needs a restart "
+                    "(teams, tick_hz, transports, engine, sinks and scheduling must stay)\n", path);
+            close(daemon_client);
+            daemon_client = -1;
+            continue;
+        }
+        cfg = next;
+        free(game_config);
+        config_path = game_config = strdup(path);
+        watch_config();
+
+        printf("\n[DAEMON] Game %d: %s, seed %u\n", games + 1, config_path, seed);
+        startup_mark("waiting for a request", 0);
+        start_next_game(seed);
+        int winner = play_game(NULL);
+        print_game_results();
+        games++;
+
+        char scores[128];
+        int len = 0;
+        for (int t = 0; t < num_teams; t++) {
+            len += snprintf(scores + len, sizeof(scores) - len, "%s%d", t ? "," : "",
+                            match.team_scores[t]);
+        }
+        dprintf(daemon_client, "%s seed=%u winner=%d rounds=%d scores=%s start_ms=%.1f "
+                "first_tick_ms=%.1f\n", game_aborted ? "aborted" : "done", seed, winner,
+                round_number, scores, (game_start_ns - request_ns) / 1e6,
+                first_tick_ns ? (first_tick_ns - request_ns) / 1e6 : -1.0);
+        close(daemon_client);
+        daemon_client = -1;
+    }
+
+    close(daemon_fd);
+    unlink(socket_path);
+    return 0;
+}
+
+/**
+ * --send: ask the daemon on socket_path for a game and print its result
+ */
+int send_game_request(const char *socket_path, const char *config_file, unsigned int seed,
+                      int has_seed) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    char path[4096];
+    if (strlen(socket_path) >= sizeof(addr.sun_path) || !realpath(config_file, path)) {
+        fprintf(stderr, "Bad socket path or config file\n");
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("connect to the daemon failed");
+        return 1;
+    }
+    if (has_seed)
+        dprintf(fd, "start %s %u\n", path, seed);
+    else
+        dprintf(fd, "start %s\n", path);
+
+    char reply[512];
+    int len = 0, n;
+    while (len < (int)sizeof(reply) - 1 && (n = read(fd, reply + len, sizeof(reply) - 1 - len)) > 0)
+        len += n;
+    reply[len] = '\0';
+    close(fd);
+    printf("%s", reply);
+    return strncmp(reply, "done", 4) == 0 ? 0 : 1;
+}
+
+/**
+ * Main function - initialize game and manage rounds
+ */
+int main(int argc, char *argv[])
+{
+    launch_ns = mono_ns();
+
+    // Check command line arguments
+    int headless = 0;            // no graphics process
+    int virtual_clock = 0;       // simulate in-process, no processes or sleeps
+    int games = 1;
+    unsigned int seed = time(NULL);
+    const char *record_path = NULL;  // replay log to write
+    const char *compile_path = NULL; // --compile-config output
+    const char *daemon_path = NULL;  // --daemon socket to serve games on
+    const char *send_path = NULL;    // --send: daemon socket to ask for a game
+    const char *json_path = NULL;    // --json: JSON lines of every update
+    const char *telemetry_path = NULL; // --telemetry: binary file of every update
+    int has_seed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+        } else if (strcmp(argv[i], "--virtual-clock") == 0) {
+            virtual_clock = 1;
+        } else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+            has_seed = 1;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--compile-config") == 0 && i + 1 < argc) {
+            compile_path = argv[++i];
+        } else if (strcmp(argv[i], "--daemon") == 0 && i + 1 < argc) {
+            daemon_path = argv[++i];
+        } else if (strcmp(argv[i], "--send") == 0 && i + 1 < argc) {
+            send_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetry_path = argv[++i];
+        } else if (argv[i][0] != '-' && !config_path) {
+            config_path = argv[i];
+        } else {
+            config_path = NULL;
+            break;
+        }
+    }
+    if (!config_path || games < 1 || (virtual_clock && !headless) ||
+        (virtual_clock && (record_path || json_path || telemetry_path)) ||
+        (daemon_path && (virtual_clock || record_path))) {
+        fprintf(stderr, "Usage: %s [--headless [--virtual-clock [--games N]]] [--seed S] "
+                "[--record <log_file>] [--json <file>] [--telemetry <file>] <config_file>\n"
+                "       %s [--headless] [--json <file>] [--telemetry <file>] "
+                "--daemon <socket> <config_file>\n"
+                "       %s --send <socket> [--seed S] <config_file>\n"
+                "       %s --compile-config <blob_file> <config_file>\n",
+                argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+    if (send_path) {
+        return send_game_request(send_path, config_path, seed, has_seed);
+    }
+
+    // Load configuration, text or compiled
+    if (load_config(config_path, &cfg) != 0) {
+        return 1;
+    }
+    if (compile_path) {
+        if (config_compile(&cfg, compile_path) != 0)
+            return 1;
+        printf("Compiled %s into %s\n", config_path, compile_path);
+        return 0;
+    }
+
+    num_teams = cfg.num_teams;
+    team_size = cfg.team_size;
+
+    if (virtual_clock) {
+        return run_virtual_games(games, seed);
+    }
+
+    // Per-player state and the buffers sized by the teams
+    roster_init(num_teams * team_size);
+    team_rank = calloc(num_teams, sizeof(Ranking));
+    rank_keys = malloc(team_size * sizeof(int));
+    graphics_msg = calloc(1, GRAPHICS_MSG_SIZE(num_teams, team_size));
+    if (!team_rank || !rank_keys || !graphics_msg) {
+        perror("malloc failed");
+        return 1;
+    }
+    for (int t = 0; t < num_teams; t++) {
+        if (ranking_init(&team_rank[t], team_size) != 0) {
+            perror("malloc failed");
+            return 1;
+        }
+    }
+
+    // Player processes take two pipe ends each on our side
+    if (cfg.player_engine == ENGINE_PROCESS) {
+        raise_fd_limit(2 * roster.count + 64);
+    }
+
+    // Shared region: round clock for everyone, plus the player slots that
+    // replace the per-tick signal + pipe exchange in shm mode
+    shared = shm_create(roster.count, &shared_fd);
+    if (!shared) {
+        return 1;
+    }
+    tick_ns = 1000000000LL / cfg.tick_hz;
+    tick_grace_ns = tick_ns / 2;
+    shared->tick_ns = tick_ns;
+    shared->ipc_mode = cfg.ipc_mode;
+    shared->team_size = team_size;
+    shared->game_seed = game_seed = seed;
+    atomic_store(&shared->game, 1);
+    publish_player_params();
+    printf("[PARENT] Game seed %u\n", game_seed);
+
+    // Live counters, `rope_stat <pid>` prints them while we play
+    stats = stats_create(num_teams, team_size, &stats_fd);
+    if (stats_fd != -1)
+        printf("[PARENT] Live stats: ./rope_stat %d\n", getpid());
+
+    // A dead graphics process shows up as EPIPE/EPOLLERR, not a signal
+    signal(SIGPIPE, SIG_IGN);
+    if (loop_init(&loop) != 0) {
+        return 1;
+    }
+    watch_config();
+    if (open_sinks(json_path, telemetry_path) != 0) {
+        return 1;
+    }
+    startup_mark("setup", 0);
+
+    if (!headless) {
+        fork_graphics_process();  // Start graphics process
+        startup_mark("graphics", 1);
+    }
+
+    // Spawn player processes, or threads
+    if (cfg.player_engine == ENGINE_THREAD) {
+        spawn_player_threads();
+    } else {
+        spawn_players();
+    }
+    startup_mark("players", roster.count);
+
+    // Only now, so that graphics, the players and the sink writers don't
+    // inherit the referee's priority and CPUs
+    Tuning tuning = { cfg.referee_priority, cfg.referee_cpus, cfg.lock_memory,
+                      cfg.prefault_stack_kb };
+    tuning_apply("[PARENT]", &tuning, 1);
+    run_loop(SPAWN_SETTLE_MS, NULL);
+    startup_mark("spawn settle", 0);
+
+    if (daemon_path) {
+        if (serve_games(daemon_path) != 0)
+            return 1;
+    } else if (play_game(record_path) < 0) {
+        return 1;
+    }
+    stats_finish(stats);
+    stop_processes();
+    if (!daemon_path)
+        print_game_results();
     printf("Bye!\n");
-    
+
     return 0;
-}
\ No newline at end of file
+}
@@ -1,5 +1,7 @@
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/uio.h>
 #include "pipe.h"
 
 int init_pipes(int fds[][2], int n)
@@ -22,3 +24,44 @@ int write_effort(int write_fd, void *buffer, int buf_size)
 {
     return write(write_fd, buffer, buf_size);
 }
+
+int read_records(int read_fd, TickRecord *partial, int *partial_len, TickRecord out[],
+                 int max, int *count)
+{
+    const size_t size = sizeof(TickRecord);
+    struct iovec iov[2];
+    int iovcnt = 0;
+    int first = 0;   // out[] slot the batch starts in
+
+    *count = 0;
+    if (*partial_len > 0) {
+        iov[iovcnt].iov_base = (char *)partial + *partial_len;
+        iov[iovcnt].iov_len = size - *partial_len;
+        iovcnt++;
+        first = 1;   // the finished partial record goes to out[0]
+    }
+    iov[iovcnt].iov_base = &out[first];
+    iov[iovcnt].iov_len = (max - first) * size;
+    iovcnt++;
+
+    ssize_t n = readv(read_fd, iov, iovcnt);
+    if (n <= 0)
+        return n;
+
+    size_t rest = n;
+    if (first) {
+        if (rest < iov[0].iov_len) {
+            *partial_len += rest;
+            return n;
+        }
+        rest -= iov[0].iov_len;
+        out[0] = *partial;
+        *count = 1;
+    }
+    // Whole records in place, a tail is kept for the next call
+    *count += rest / size;
+    *partial_len = rest % size;
+    if (*partial_len > 0)
+        memcpy(partial, &out[*count], *partial_len);
+    return n;
+}
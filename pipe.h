@@ -1,6 +1,8 @@
 #ifndef PIPE_H
 #define PIPE_H
 
+#include "constant.h"
+
 // For each player, we have a pipe for child -> parent communication
 // fds[i][0] is read end, fds[i][1] is write end
 int init_pipes(int fds[][2], int n);
@@ -11,4 +13,12 @@ int read_effort(int read_fd, void *buffer, int buf_size);
 // write from child => returns number of bytes written
 int write_effort(int write_fd, void *buffer, int buf_size);
 
+// read a batch of TickRecords from child with one readv(): the first iovec
+// finishes the record left partial by the previous call (*partial, of which
+// *partial_len bytes are in), the second takes whole records into out.
+// *count gets the complete records in out, the finished partial one first.
+// => returns number of bytes read, like read_effort()
+int read_records(int read_fd, TickRecord *partial, int *partial_len, TickRecord out[],
+                 int max, int *count);
+
 #endif
@@ -0,0 +1,173 @@
+// pipe_feed.c
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pipe_feed.h"
+
+#define SLOT_FRESH  4   // in shared_slot: published and not taken yet
+
+#define SLOT_SIZE  (sizeof(GameState) + sizeof(int) * MAX_TEAMS * MAX_TEAM_SIZE)
+
+static GameState *slots[3];
+static GameState *work;             // what the thread has folded in so far
+static atomic_uint shared_slot;     // slot in the middle, | SLOT_FRESH
+static int back_slot = 1;           // the thread's
+static int front_slot = 2;          // graphics'
+
+static int pipe_fd = -1;
+static char *rx_buf = NULL;
+static size_t rx_len = 0;
+static size_t rx_cap = 0;
+
+/**
+ * Fold one update into the working snapshot, like game_state_publish()
+ */
+static void apply_message(GraphicsMessage *msg)
+{
+    const int *sums = graphics_sums(msg);
+
+    work->state_ns = msg->stateNs;
+    work->tick_ns = msg->tickNs;
+    if (msg->roundNumber == -1) {
+        // Final game message: keep the last round
+        work->game_state = GS_GAME_OVER;
+        work->game_winner = msg->roundWinner;
+        memcpy(work->final_scores, sums, msg->numTeams * sizeof(int));
+    } else {
+        work->num_teams = msg->numTeams;
+        work->team_size = msg->teamSize;
+        work->round_number = msg->roundNumber;
+        work->round_winner = msg->roundWinner;
+        work->game_state = msg->roundWinner ? GS_ROUND_ENDED : GS_PLAYING;
+        work->tick = msg->tick;
+        memcpy(work->effort_sums, sums, msg->numTeams * sizeof(int));
+        memcpy(work->energies, graphics_energies(msg),
+               (size_t)msg->numTeams * msg->teamSize * sizeof(int));
+    }
+    unsigned int seq = atomic_load_explicit(&work->seq, memory_order_relaxed);
+    atomic_store_explicit(&work->seq, seq + 1, memory_order_relaxed);
+}
+
+/**
+ * Copy the working snapshot into the thread's slot and swap it into the
+ * middle; the slot that was there becomes the thread's
+ */
+static void publish(void)
+{
+    GameState *s = slots[back_slot];
+    atomic_store_explicit(&s->seq, atomic_load_explicit(&work->seq, memory_order_relaxed),
+                          memory_order_relaxed);
+    s->num_teams = work->num_teams;
+    s->team_size = work->team_size;
+    s->round_number = work->round_number;
+    s->round_winner = work->round_winner;
+    s->game_state = work->game_state;
+    s->game_winner = work->game_winner;
+    s->tick = work->tick;
+    s->state_ns = work->state_ns;
+    s->tick_ns = work->tick_ns;
+    memcpy(s->effort_sums, work->effort_sums, sizeof(s->effort_sums));
+    memcpy(s->final_scores, work->final_scores, sizeof(s->final_scores));
+    memcpy(s->energies, work->energies, (size_t)work->num_teams * work->team_size * sizeof(int));
+
+    unsigned int old = atomic_exchange_explicit(&shared_slot, back_slot | SLOT_FRESH,
+                                                memory_order_acq_rel);
+    back_slot = old & ~SLOT_FRESH;
+}
+
+/**
+ * Fold in every complete update in rx_buf => number folded in
+ */
+static int apply_received(void)
+{
+    size_t used = 0;
+    int applied = 0;
+    while (rx_len - used >= sizeof(GraphicsMessage)) {
+        GraphicsMessage *msg = (GraphicsMessage *)(rx_buf + used);
+        if (msg->numTeams < 2 || msg->numTeams > MAX_TEAMS ||
+            msg->teamSize < 0 || msg->teamSize > MAX_TEAM_SIZE) {
+            fprintf(stderr, "Bad update from the referee, dropping %zu bytes\n", rx_len - used);
+            used = rx_len;
+            break;
+        }
+        size_t size = GRAPHICS_MSG_SIZE(msg->numTeams, msg->teamSize);
+        if (rx_len - used < size)
+            break;   // rest of this update still in the pipe
+        apply_message(msg);
+        applied++;
+        used += size;
+    }
+    memmove(rx_buf, rx_buf + used, rx_len - used);
+    rx_len -= used;
+    return applied;
+}
+
+static void *ingest_main(void *arg)
+{
+    for (;;) {
+        if (rx_cap - rx_len < 4096) {
+            rx_cap = rx_cap ? rx_cap * 2 : 8192;
+            rx_buf = realloc(rx_buf, rx_cap);
+            if (!rx_buf) {
+                perror("realloc failed");
+                exit(1);
+            }
+        }
+        // Blocks until the referee writes; a burst comes back in one read
+        ssize_t bytes = read(pipe_fd, rx_buf + rx_len, rx_cap - rx_len);
+        if (bytes == -1 && errno == EINTR)
+            continue;
+        if (bytes <= 0)
+            break;   // referee gone, graphics keeps showing the last snapshot
+        rx_len += bytes;
+
+        if (apply_received() > 0)
+            publish();
+    }
+    return NULL;
+}
+
+int pipe_feed_start(int fd)
+{
+    for (int k = 0; k < 3; k++) {
+        slots[k] = calloc(1, SLOT_SIZE);
+        if (!slots[k]) {
+            perror("calloc failed");
+            return -1;
+        }
+    }
+    work = calloc(1, SLOT_SIZE);
+    if (!work) {
+        perror("calloc failed");
+        return -1;
+    }
+    work->num_teams = 2;
+    work->game_state = GS_WAITING;
+    atomic_store_explicit(&shared_slot, 0, memory_order_relaxed);
+
+    // The thread does the waiting now
+    pipe_fd = fd;
+    int flags = fcntl(pipe_fd, F_GETFL, 0);
+    fcntl(pipe_fd, F_SETFL, flags & ~O_NONBLOCK);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, ingest_main, NULL) != 0) {
+        perror("pthread_create ingest failed");
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+const GameState *pipe_feed_latest(void)
+{
+    if (!(atomic_load_explicit(&shared_slot, memory_order_relaxed) & SLOT_FRESH))
+        return NULL;
+    unsigned int old = atomic_exchange_explicit(&shared_slot, front_slot, memory_order_acq_rel);
+    front_slot = old & ~SLOT_FRESH;
+    return slots[front_slot];
+}
@@ -0,0 +1,22 @@
+// pipe_feed.h
+#ifndef PIPE_FEED_H
+#define PIPE_FEED_H
+
+#include "game_state.h"
+
+// Pipe feed of graphics (graphics_feed pipe). One thread blocks on the
+// referee's pipe and folds every GraphicsMessage into a GameState snapshot,
+// published through a triple buffer: the thread always has a slot of its own
+// to fill, graphics always has the slot it is showing, and the third holds
+// the newest complete snapshot. Neither side ever waits for the other, so a
+// burst of updates costs graphics one snapshot swap, not one frame per
+// update, and a long frame does not hold the pipe up.
+
+// Start the ingest thread on the pipe fd => 0, or -1
+int pipe_feed_start(int fd);
+
+// Newest snapshot published since the last call, or NULL if there is none.
+// It stays valid until the next call. Its seq counts the updates folded in.
+const GameState *pipe_feed_latest(void);
+
+#endif
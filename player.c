@@ -1,6 +1,11 @@
 /**
  * Player process implementation for the Rope Pulling Game
  * Each player has energy and pulls based on location and energy level
+ *
+ * The referee's signals stay blocked and are read from a signalfd by an
+ * event loop (loop.h), next to the tick timer. Every handler runs in normal
+ * context, one at a time, so a request is answered between two ticks at
+ * worst, never from inside a nested handler.
  */
 
 #include <stdio.h>
@@ -8,66 +13,122 @@
 #include <unistd.h>
 #include <signal.h>
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/signal.h>
+#include <sys/signalfd.h>
+#include <sys/epoll.h>
 #include "constant.h"
 #include "pipe.h"
 #include "config.h"
+#include "shm.h"
+#include "stats.h"
+#include "player_logic.h"
+#include "launch.h"
+#include "loop.h"
+
+#define TAG_SIGNALS 0   // loop tag of our signalfd
+#define TICK_BATCH  16  // tick records written at once when ticks fall behind
 
 /* Global variables */
-static int max_energy = 100;              // Maximum energy for the player
-static int min_energy = 0;                // Minimum energy for the player
+static PlayerParams params = {            // Energy, decay and recovery ranges
+    .energy_min = 0, .energy_max = 100,
+    .decay_min = 1, .decay_max = 2,
+    .recover_min = 1, .recover_max = 2
+};
+static RngKey rng_key_me;                 // (game seed, our index) => our draws
+static int resets = 0;                    // SIG_RESET_ENERGY so far, one per round
+static int game = 0;                      // game of the shared region we play
+static int my_index;                      // referee index, team * team_size + id
 static PlayerData me;                     // Player state information
 static int write_fd_effort = -1;          // Pipe to write effort to parent
 static int read_fd_loc = -1;              // Pipe to read location from parent
-static int decay_min = 1;                 // Min energy decay per second
-static int decay_max = 2;                 // Max energy decay per second
-static int recover_min = 1;               // Min recovery time when fallen
-static int recover_max = 2;               // Max recovery time when fallen
 static int pulling = 0; // Flag indicating if player is pulling
 static int initial_energy;                // Initial energy value
+static SharedState *shared = NULL;        // Shared region (round clock, slots)
+static PlayerSlot *my_slot = NULL;        // Our slot inside it (shm mode only)
+static int slot_round = 0;                // Round the slot data belongs to
+static int slot_tick = 0;                 // Ticks played in the current round
+static int effort_sum = 0;                // Effort accumulated over the round
+static StatCounters *my_stats = NULL;     // Our counters in the referee's stats page
+static EventLoop loop;                    // Tick timer + our signalfd
+static int signal_fd = -1;                // The referee's signals
+static int pull_round = 0;                // Round we pull in
+static long long next_tick = 1;           // Next tick of that round to play
+static int running = 1;                   // Cleared by SIG_TERMINATE
+static unsigned int records_sent = 0;     // TickRecord seq
+
+/**
+ * Block the referee's signals and read them from a signalfd instead => 0,
+ * or -1. launch_player() starts us with them blocked already, so none that
+ * is sent early gets lost.
+ */
+int setup_signals() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIG_PULL);
+    sigaddset(&mask, SIG_STOP);
+    sigaddset(&mask, SIG_ENERGY_REQ);
+    sigaddset(&mask, SIG_SET_LOC);
+    sigaddset(&mask, SIG_READY);
+    sigaddset(&mask, SIG_TERMINATE);
+    sigaddset(&mask, SIG_RESET_ENERGY);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+        perror("sigprocmask failed");
+        return -1;
+    }
+    signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd == -1) {
+        perror("signalfd failed");
+        return -1;
+    }
+    return loop_watch(&loop, signal_fd, EPOLLIN, TAG_SIGNALS);
+}
 
-/* Signal handlers prototypes */
-void on_energy_req(int sig);
-void on_set_loc(int sig);
-void on_ready(int sig);
-void on_terminate(int sig);
-void on_stop(int sig);
-void on_reset_energy(int sig);
-void on_pull(int sig);
-
-/**
- * Set up all signal handlers for the player process
- */
-void setup_signal_handlers() {
-    signal(SIG_PULL, on_pull);
-    signal(SIG_STOP, on_stop);
-    signal(SIG_ENERGY_REQ, on_energy_req);
-    signal(SIG_SET_LOC, on_set_loc);
-    signal(SIG_READY, on_ready);
-    signal(SIG_TERMINATE, on_terminate);
-    signal(SIG_RESET_ENERGY, on_reset_energy);
+/**
+ * Publish the current state into the shared-memory slot, if we have one
+ */
+void publish_slot(int weighted_effort) {
+    if (my_slot)
+        slot_publish(my_slot, &me, slot_round, slot_tick, weighted_effort, effort_sum);
 }
 
 /**
- * Handle energy request from parent - report current energy level
+ * Handle energy request from parent - report current state as tick 0
  */
-void on_energy_req(int sig) {
-    EnergyReply er;
-    er.player_id = me.id;
-    er.team = me.team;
-    er.energy = me.energy;  // Raw energy
-    er.location = me.location;
-    write_effort(write_fd_effort, &er, sizeof(er));
+void on_energy_req() {
+    stat_inc(&my_stats->signals_received);
+    TickRecord rec;
+    player_record(&rec, &me, atomic_load(&shared->round), 0, 0, records_sent++);
+    write_effort(write_fd_effort, &rec, sizeof(rec));
+    stat_inc(&my_stats->messages_sent);
 }
 
 /**
- * Handle location assignment from parent
+ * Handle location assignment from parent. SIG_SET_LOC is a standard signal,
+ * pending copies merge into one, so the pipe may hold several locations:
+ * read them all, the last one is ours.
  */
-void on_set_loc(int sig) {
-    LocationMessage lm;
-    int bytes = read_effort(read_fd_loc, &lm, sizeof(lm));
-    if (bytes == sizeof(lm) && lm.player_id == me.id) {
-        me.location = lm.location;
+void on_set_loc() {
+    stat_inc(&my_stats->signals_received);
+    int location = -1;
+    for (;;) {
+        LocationMessage lm;
+        int bytes = read_effort(read_fd_loc, &lm, sizeof(lm));
+        if (bytes <= 0)
+            break;   // empty (EAGAIN), or the referee is gone
+        if (bytes < (int)sizeof(lm)) {
+            stat_inc(&my_stats->short_reads);
+            continue;
+        }
+        stat_inc(&my_stats->messages_received);
+        if (lm.player_id == me.id)
+            location = lm.location;
+    }
+    if (location != -1) {
+        me.location = location;
+        if (!pulling)
+            publish_slot(0);
         printf("[Player %d, Team %d] Assigned location = %d\n", me.id, me.team, me.location);
     }
 }
@@ -75,127 +136,244 @@ void on_set_loc(int sig) {
 /**
  * Handle ready signal - game is about to begin
  */
-void on_ready(int sig) {
+void on_ready() {
+    stat_inc(&my_stats->signals_received);
     printf("[Player %d, Team %d] SIG_READY \n",me.id, me.team);
 }
 
 /**
  * Handle termination signal
  */
-void on_terminate(int sig) {
+void on_terminate() {
     printf("[Player %d, Team %d] Terminating...\n", me.id, me.team);
-    fflush(stdout);
-    exit(0);
+    running = 0;
 }
 
 /**
  * Reset player energy to random value within configured range
  */
-void on_reset_energy(int sig) {
-    me.energy = (rand() % (max_energy - min_energy + 1)) + min_energy;
-    me.is_fallen = 0;
-    me.fall_time_left = 0;
+void on_reset_energy() {
+    stat_inc(&my_stats->signals_received);
+    params = shared->params;   // the config may have been reloaded
+    if (atomic_load(&shared->game) != game) {
+        // Next game of a daemon referee: start it like a fresh player
+        game = atomic_load(&shared->game);
+        resets = 0;
+        rng_key_me = rng_key(shared->game_seed, my_index);
+        player_spawn(&me, &params, shared->game_seed, my_index);
+    } else {
+        resets++;
+        player_reset_energy(&me, &params, rng_key_me, resets);
+    }
+    if (!pulling)
+        publish_slot(0);
 }
 
 /**
- * Simulate one second of gameplay - handle energy decay, falling, recovery
+ * Simulate one tick of gameplay (one second at the default tick_hz of 1)
+ * - handle energy decay, falling, recovery
+ * => 1 if rec holds the tick's record for the effort pipe
  */
-void do_one_second_of_play() {
+int do_one_second_of_play(int round, int tick, TickRecord *rec) {
     if (!pulling)
-        return;
+        return 0;
 
-    if (me.is_fallen) {
-        me.fall_time_left--;
-        if (me.fall_time_left <= 0) {
-            me.is_fallen = 0;
-            me.energy = (rand() % 50) + 50;
-            
-            // Cap energy at max_energy to prevent exceeding limit
-            if (me.energy > max_energy)
-                me.energy = max_energy;
-                
-            printf("[Player %d, Team %d] Recovered from fall. energy=%d\n",
-                   me.id, me.team, me.energy);
-        }
-    } else {
-        int random_decay = (rand() % (decay_max - decay_min + 1)) + decay_min;
-        me.energy -= random_decay;
-
-        // 10% chance of falling or if energy depletes
-        if (me.energy <= 0 || (rand() % 100) < 10) {
-            me.energy = me.energy < 0 ? 0 : me.energy;
-            me.is_fallen = 1;
-            me.fall_time_left = (rand() % (recover_max - recover_min + 1)) + recover_min;
-            printf("[Player %d, Team %d] Fell. Will recover in %d sec\n",
-                   me.id, me.team, me.fall_time_left);
-        }
+    // State machine shared with the headless simulation (player_logic.c)
+    int event;
+    int weighted_effort = player_tick(&me, &params, rng_key_me, round, tick, &event);
+    stat_inc(&my_stats->ticks);
+
+    if (event == PLAYER_EVENT_RECOVERED) {
+        printf("[Player %d, Team %d] Recovered from fall. energy=%d\n",
+               me.id, me.team, me.energy);
+    } else if (event == PLAYER_EVENT_FELL) {
+        printf("[Player %d, Team %d] Fell. Will recover in %d sec\n",
+               me.id, me.team, me.fall_time_left);
+    }
+
+    if (my_slot) {
+        // Shared-memory mode: the referee reads the slot, no pipe message
+        slot_tick++;
+        effort_sum += weighted_effort;
+        publish_slot(weighted_effort);
+        return 0;
     }
+    player_record(rec, &me, round, tick, weighted_effort, records_sent++);
+    return 1;
+}
 
-    EffortMessage msg = {
-        .player_id = me.id,
-        .team = me.team,
-        .location = me.location,
-        .weighted_effort = me.is_fallen ? 0 : me.energy * (1 + me.location)
-    };
-    write_effort(write_fd_effort, &msg, sizeof(msg));
+/**
+ * Send the tick records of a batch in one write
+ */
+void send_records(TickRecord recs[], int n) {
+    if (n == 0)
+        return;
+    write_effort(write_fd_effort, recs, n * sizeof(TickRecord));
+    stat_add(&my_stats->messages_sent, n);
 }
 
 /**
  * Handle pull signal - start pulling
  */
-void on_pull(int sig) {
+void on_pull() {
+    stat_inc(&my_stats->signals_received);
     printf("[Player %d, Team %d] SIG_PULL => Start pulling\n", me.id, me.team);
     pulling = 1;
-    while (pulling) {
-        sleep(1);
-        do_one_second_of_play();
+    pull_round = atomic_load(&shared->round);
+    next_tick = 1;
+
+    if (my_slot) {
+        // New round => start a fresh version of the slot
+        slot_round = pull_round;
+        slot_tick = 0;
+        effort_sum = 0;
+        publish_slot(0);
+    }
+    // Ticks are scheduled against the round epoch shared with the referee,
+    // so the players and the referee never drift apart
+    long long period = shared->tick_ns;
+    loop_set_timer(&loop, atomic_load(&shared->epoch_ns) + period, period);
+}
+
+/**
+ * Play the ticks that came due, expired of them
+ */
+void on_ticks(uint64_t expired) {
+    if (!pulling || expired == 0)
+        return;
+    if (expired > 1)
+        stat_add(&my_stats->tick_overruns, expired - 1);   // woke up past the next tick
+    TickRecord recs[TICK_BATCH];
+    int n = 0;
+    while (expired-- > 0 && pulling) {
+        n += do_one_second_of_play(pull_round, next_tick++, &recs[n]);
+        if (n == TICK_BATCH) {
+            send_records(recs, n);
+            n = 0;
+        }
     }
+    send_records(recs, n);
 }
 
 /**
  * Handle stop signal - stop pulling
  */
-void on_stop(int sig) {
+void on_stop() {
+    stat_inc(&my_stats->signals_received);
     pulling = 0;
+    loop_set_timer(&loop, 0, 0);
     printf("[Player %d, Team %d] Stopped pulling\n", me.id, me.team); // Optional debug
 }
 
+/**
+ * Handle one signal of the referee
+ */
+void on_signal(int sig) {
+    if (sig == SIG_ENERGY_REQ)
+        on_energy_req();
+    else if (sig == SIG_SET_LOC)
+        on_set_loc();
+    else if (sig == SIG_READY)
+        on_ready();
+    else if (sig == SIG_PULL)
+        on_pull();
+    else if (sig == SIG_STOP)
+        on_stop();
+    else if (sig == SIG_RESET_ENERGY)
+        on_reset_energy();
+    else if (sig == SIG_TERMINATE)
+        on_terminate();
+}
+
+/**
+ * Handle every signal the referee has sent. signalfd hands out the standard
+ * signals (energy request, location, terminate) before the queued commands,
+ * but the referee sends a command before the requests that must see it, as
+ * reset then energy request: the commands of a batch go first.
+ */
+void on_signals() {
+    struct signalfd_siginfo si[16];
+    ssize_t bytes;
+    while (running && (bytes = read(signal_fd, si, sizeof(si))) > 0) {
+        int n = bytes / sizeof(si[0]);
+        for (int k = 0; k < n && running; k++) {
+            if ((int)si[k].ssi_signo >= SIGRTMIN)
+                on_signal(si[k].ssi_signo);
+        }
+        for (int k = 0; k < n && running; k++) {
+            if ((int)si[k].ssi_signo < SIGRTMIN)
+                on_signal(si[k].ssi_signo);
+        }
+    }
+}
+
 /**
  * Main function - initialize player and wait for signals
  */
 int main(int argc, char *argv[]) {
-    srand(time(NULL) ^ getpid());
-
-    // Initialize player data
-    me.id = atoi(argv[1]);
-    me.team = atoi(argv[2]);
-    me.decay_rate = atoi(argv[3]);
-    me.energy = initial_energy = atoi(argv[4]);
-    write_fd_effort = atoi(argv[5]);
-    read_fd_loc = atoi(argv[6]);
-
-    if (argc > 7)
-        decay_min = atoi(argv[7]);
-    if (argc > 8)
-        decay_max = atoi(argv[8]);
-    if (argc > 9)
-        recover_min = atoi(argv[9]);
-    if (argc > 10)
-        recover_max = atoi(argv[10]);
-    if (argc > 11)
-        max_energy = atoi(argv[11]);
-    if (argc > 12)
-        min_energy = atoi(argv[12]);
+    if (loop_init(&loop) != 0 || setup_signals() != 0)
+        exit(1);
+
+    // Everything the referee tells us comes in one block (launch.h)
+    PlayerLaunch pl;
+    if (launch_read(&pl) != 0) {
+        fprintf(stderr, "%s: no launch block on fd %d, start me from rope_game\n", argv[0],
+                LAUNCH_FD_BLOCK);
+        exit(1);
+    }
+    me.id = pl.id;
+    me.team = pl.team;
+    me.decay_rate = pl.decay_rate;
+    me.energy = initial_energy = pl.energy;
+    params = pl.params;
+    write_fd_effort = LAUNCH_FD_EFFORT;
+    read_fd_loc = LAUNCH_FD_LOC;
+    // on_set_loc() reads until the pipe is empty
+    fcntl(read_fd_loc, F_SETFL, fcntl(read_fd_loc, F_GETFL) | O_NONBLOCK);
+
+    char who[48];
+    snprintf(who, sizeof(who), "[Player %d, Team %d]", me.id, me.team);
+    tuning_apply(who, &pl.tuning, 0);
 
     me.is_fallen = 0;
     me.location = 0;
     me.fall_time_left = 0;
 
-    setup_signal_handlers();
+    // Shared region holding the round clock and, in shm mode, our slot
+    shared = shm_attach(LAUNCH_FD_SHARED);
+    if (!shared)
+        exit(1);
+    // Live counters, private ones if the referee couldn't share its page
+    int index = me.team * shared->team_size + me.id;
+    my_index = index;
+    game = atomic_load(&shared->game);
+    rng_key_me = rng_key(shared->game_seed, index);
+    StatsPage *stats = stats_attach(pl.has_stats ? LAUNCH_FD_STATS : -1, index + 1);
+    my_stats = &stats->players[index];
 
-    while (1) {
-        pause();
+    if (shared->ipc_mode == IPC_SHM) {
+        my_slot = &shared->slots[index];
+        publish_slot(0);
     }
 
+    // Signals before ticks: both are ready => answer the referee first
+    while (running) {
+        LoopEvent evs[2];
+        int n = loop_wait(&loop, evs, 2, -1);
+        if (n < 0)
+            exit(1);
+        if (n == 2 && evs[0].tag == LOOP_TAG_TIMER) {
+            LoopEvent timer = evs[0];
+            evs[0] = evs[1];
+            evs[1] = timer;
+        }
+        for (int k = 0; k < n && running; k++) {
+            if (evs[k].tag == TAG_SIGNALS)
+                on_signals();
+            else if (evs[k].tag == LOOP_TAG_TIMER)
+                on_ticks(loop_read_timer(&loop));
+        }
+    }
+    fflush(stdout);
     return 0;
 }
\ No newline at end of file
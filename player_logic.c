@@ -0,0 +1,71 @@
+// player_logic.c
+#include "player_logic.h"
+
+int player_tick(PlayerData *me, const PlayerParams *pp, RngKey key, int round, int tick,
+                int *event)
+{
+    uint32_t draw[4];
+    rng_block(key, RNG_TICK, tick, round, draw);
+    *event = PLAYER_EVENT_NONE;
+
+    if (me->is_fallen) {
+        me->fall_time_left--;
+        if (me->fall_time_left <= 0) {
+            me->is_fallen = 0;
+            me->energy = rng_range(draw[DRAW_ENERGY], 50, 99);
+
+            // Cap energy at max_energy to prevent exceeding limit
+            if (me->energy > pp->energy_max)
+                me->energy = pp->energy_max;
+            *event = PLAYER_EVENT_RECOVERED;
+        }
+    } else {
+        int random_decay = rng_range(draw[DRAW_ENERGY], pp->decay_min, pp->decay_max);
+        me->energy -= random_decay;
+
+        // 10% chance of falling or if energy depletes
+        if (me->energy <= 0 || rng_range(draw[DRAW_FALL], 0, 99) < 10) {
+            me->energy = me->energy < 0 ? 0 : me->energy;
+            me->is_fallen = 1;
+            me->fall_time_left = rng_range(draw[DRAW_RECOVER], pp->recover_min, pp->recover_max);
+            *event = PLAYER_EVENT_FELL;
+        }
+    }
+
+    return me->is_fallen ? 0 : me->energy * (1 + me->location);
+}
+
+void player_reset_energy(PlayerData *me, const PlayerParams *pp, RngKey key, int round)
+{
+    uint32_t draw[4];
+    rng_block(key, RNG_RESET, round, 0, draw);
+    me->energy = rng_range(draw[0], pp->energy_min, pp->energy_max);
+    me->is_fallen = 0;
+    me->fall_time_left = 0;
+}
+
+void player_spawn(PlayerData *me, const PlayerParams *pp, uint32_t game_seed, int index)
+{
+    uint32_t draw[4];
+    rng_block(rng_key(game_seed, RNG_REFEREE), RNG_SPAWN, index, 0, draw);
+    me->energy = rng_range(draw[0], pp->energy_min, pp->energy_max);
+    me->decay_rate = rng_range(draw[1], pp->decay_min, pp->decay_max);
+    me->is_fallen = 0;
+    me->location = 0;
+    me->fall_time_left = 0;
+}
+
+void player_record(TickRecord *rec, const PlayerData *me, int round, int tick,
+                   int weighted_effort, unsigned int seq)
+{
+    rec->player_id = me->id;
+    rec->team = me->team;
+    rec->round = round;
+    rec->tick = tick;
+    rec->energy = me->energy;
+    rec->location = me->location;
+    rec->is_fallen = me->is_fallen;
+    rec->fall_time_left = me->fall_time_left;
+    rec->weighted_effort = weighted_effort;
+    rec->seq = seq;
+}
@@ -0,0 +1,47 @@
+// player_logic.h
+#ifndef PLAYER_LOGIC_H
+#define PLAYER_LOGIC_H
+
+#include "constant.h"
+#include "rng.h"
+
+// Ranges a player draws from, taken from config.txt
+typedef struct {
+    int energy_min;
+    int energy_max;
+    int decay_min;
+    int decay_max;
+    int recover_min;
+    int recover_max;
+} PlayerParams;
+
+// What happened during a tick, for the caller's log
+#define PLAYER_EVENT_NONE       0
+#define PLAYER_EVENT_FELL       1
+#define PLAYER_EVENT_RECOVERED  2
+
+// Draws of a tick, by position in the tick's random block (rng.h)
+#define DRAW_ENERGY   0   // recovery energy, or decay while standing
+#define DRAW_FALL     1   // 10% chance of falling
+#define DRAW_RECOVER  2   // seconds on the ground
+
+// Play tick `tick` of round `round`: energy decay, falling and recovery.
+// Returns the weighted effort of the tick, *event tells what happened.
+// All randomness comes from the player's key and (round, tick), so any
+// player's tick gives the same result wherever and whenever it is played.
+int player_tick(PlayerData *me, const PlayerParams *pp, RngKey key, int round, int tick,
+                int *event);
+
+// Reset energy to a random value within the configured range, before round
+void player_reset_energy(PlayerData *me, const PlayerParams *pp, RngKey key, int round);
+
+// Fill rec with me's state after tick `tick` of `round` (0 => a state
+// report), numbered seq
+void player_record(TickRecord *rec, const PlayerData *me, int round, int tick,
+                   int weighted_effort, unsigned int seq);
+
+// State player `index` starts a game of game_seed in: energy and decay rate
+// from the referee's stream, standing, no location yet
+void player_spawn(PlayerData *me, const PlayerParams *pp, uint32_t game_seed, int index);
+
+#endif
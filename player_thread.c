@@ -0,0 +1,323 @@
+// player_thread.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "config.h"
+#include "loop.h"
+#include "player_thread.h"
+
+#define CMD_QUEUE_SIZE    64
+#define REPLY_QUEUE_SIZE  256
+
+typedef struct {
+    int sig;   // SIG_* code from constant.h
+    int arg;   // location for SIG_SET_LOC
+} PlayerCommand;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;              // command queued
+    PlayerCommand cmds[CMD_QUEUE_SIZE];
+    int head;
+    int count;
+
+    int index;                        // referee index
+    StatCounters *stats;              // our counters in the stats page
+    PlayerData me;                    // Player state information
+    RngKey key;                       // (game seed, index) => our draws
+    PlayerParams params;              // ranges, taken from shared at each reset
+    int resets;                       // SIG_RESET_ENERGY so far, one per round
+    int game;                         // game of the shared region we play
+    int pulling;
+    long long epoch_ns;               // round clock, see shm.h
+    long long next_tick;              // index of the next tick to play
+    unsigned int records_sent;        // TickRecord seq
+
+    // Shared-memory mode bookkeeping, as in player.c
+    int slot_round;
+    int slot_tick;
+    int effort_sum;
+} ThreadPlayer;
+
+static ThreadPlayer *tps = NULL;
+static int n_players = 0;
+static SharedState *shared = NULL;
+static Tuning tuning;                 // threads_start(), applied by each thread
+static int tuned = 0;
+
+// Reply queue: every player produces, the referee consumes
+static pthread_mutex_t reply_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reply_space = PTHREAD_COND_INITIALIZER;
+static ThreadReply replies[REPLY_QUEUE_SIZE];
+static int reply_head = 0;
+static int reply_count = 0;
+static int reply_fd = -1;             // eventfd polled by the referee
+
+/**
+ * Queue a record for the referee and wake its event loop
+ */
+static void push_reply(ThreadPlayer *tp, int tick, int weighted_effort)
+{
+    pthread_mutex_lock(&reply_lock);
+    while (reply_count == REPLY_QUEUE_SIZE)
+        pthread_cond_wait(&reply_space, &reply_lock);
+
+    ThreadReply *r = &replies[(reply_head + reply_count) % REPLY_QUEUE_SIZE];
+    r->index = tp->index;
+    player_record(&r->rec, &tp->me, tp->slot_round, tick, weighted_effort, tp->records_sent++);
+    reply_count++;
+    pthread_mutex_unlock(&reply_lock);
+    stat_inc(&tp->stats->messages_sent);
+
+    uint64_t one = 1;
+    if (write(reply_fd, &one, sizeof(one)) != sizeof(one))
+        perror("eventfd write failed");
+}
+
+static void publish_slot(ThreadPlayer *tp, int weighted_effort)
+{
+    if (shared->ipc_mode == IPC_SHM)
+        slot_publish(&shared->slots[tp->index], &tp->me, tp->slot_round,
+                     tp->slot_tick, weighted_effort, tp->effort_sum);
+}
+
+/**
+ * One tick of play, same state machine as the player process
+ */
+static void play_tick(ThreadPlayer *tp, int tick)
+{
+    PlayerData *me = &tp->me;
+    int event;
+    int weighted_effort = player_tick(me, &tp->params, tp->key, tp->slot_round, tick, &event);
+    stat_inc(&tp->stats->ticks);
+
+    if (event == PLAYER_EVENT_RECOVERED) {
+        printf("[Player %d, Team %d] Recovered from fall. energy=%d\n",
+               me->id, me->team, me->energy);
+    } else if (event == PLAYER_EVENT_FELL) {
+        printf("[Player %d, Team %d] Fell. Will recover in %d sec\n",
+               me->id, me->team, me->fall_time_left);
+    }
+
+    if (shared->ipc_mode == IPC_SHM) {
+        tp->slot_tick++;
+        tp->effort_sum += weighted_effort;
+        publish_slot(tp, weighted_effort);
+        return;
+    }
+    push_reply(tp, tick, weighted_effort);
+}
+
+/**
+ * Apply one command => 0 to keep running, -1 on SIG_TERMINATE
+ */
+static int handle_command(ThreadPlayer *tp, const PlayerCommand *c)
+{
+    PlayerData *me = &tp->me;
+
+    stat_inc(&tp->stats->signals_received);
+    if (c->sig == SIG_ENERGY_REQ) {
+        push_reply(tp, 0, 0);   // state report
+    } else if (c->sig == SIG_SET_LOC) {
+        me->location = c->arg;
+        printf("[Player %d, Team %d] Assigned location = %d\n", me->id, me->team, me->location);
+        if (!tp->pulling)
+            publish_slot(tp, 0);
+    } else if (c->sig == SIG_READY) {
+        printf("[Player %d, Team %d] SIG_READY \n", me->id, me->team);
+    } else if (c->sig == SIG_PULL) {
+        printf("[Player %d, Team %d] SIG_PULL => Start pulling\n", me->id, me->team);
+        tp->pulling = 1;
+        tp->epoch_ns = atomic_load(&shared->epoch_ns);
+        tp->next_tick = 1;
+        tp->slot_round = atomic_load(&shared->round);
+        tp->slot_tick = 0;
+        tp->effort_sum = 0;
+        publish_slot(tp, 0);
+    } else if (c->sig == SIG_STOP) {
+        tp->pulling = 0;
+        printf("[Player %d, Team %d] Stopped pulling\n", me->id, me->team);
+    } else if (c->sig == SIG_RESET_ENERGY) {
+        tp->params = shared->params;   // the config may have been reloaded
+        if (atomic_load(&shared->game) != tp->game) {
+            // Next game of a daemon referee, as in player.c
+            tp->game = atomic_load(&shared->game);
+            tp->resets = 0;
+            tp->key = rng_key(shared->game_seed, tp->index);
+            player_spawn(me, &tp->params, shared->game_seed, tp->index);
+        } else {
+            player_reset_energy(me, &tp->params, tp->key, ++tp->resets);
+        }
+        if (!tp->pulling)
+            publish_slot(tp, 0);
+    } else if (c->sig == SIG_TERMINATE) {
+        printf("[Player %d, Team %d] Terminating...\n", me->id, me->team);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Player thread: wait for commands, or for the next tick while pulling.
+ * The lock only guards the command queue: replies may wait for room in the
+ * referee's queue, and the referee must be able to queue commands meanwhile.
+ */
+static void *player_main(void *arg)
+{
+    ThreadPlayer *tp = arg;
+
+    if (tuned) {
+        char who[48];
+        snprintf(who, sizeof(who), "[Player %d, Team %d]", tp->me.id, tp->me.team);
+        tuning_apply(who, &tuning, 0);
+    }
+
+    pthread_mutex_lock(&tp->lock);
+    for (;;) {
+        if (tp->count > 0) {
+            PlayerCommand c = tp->cmds[tp->head];
+            tp->head = (tp->head + 1) % CMD_QUEUE_SIZE;
+            tp->count--;
+            pthread_mutex_unlock(&tp->lock);
+            int done = handle_command(tp, &c);
+            pthread_mutex_lock(&tp->lock);
+            if (done != 0)
+                break;
+            continue;
+        }
+
+        if (!tp->pulling) {
+            pthread_cond_wait(&tp->cond, &tp->lock);
+            continue;
+        }
+
+        // Ticks follow the round clock shared with the referee
+        long long due = tp->epoch_ns + tp->next_tick * shared->tick_ns;
+        long long now = mono_ns();
+        if (now >= due) {
+            if (now >= due + shared->tick_ns)
+                stat_inc(&tp->stats->tick_overruns);   // the next tick is due already
+            pthread_mutex_unlock(&tp->lock);
+            play_tick(tp, tp->next_tick++);
+            pthread_mutex_lock(&tp->lock);
+            continue;
+        }
+        struct timespec ts;
+        ts.tv_sec = due / 1000000000LL;
+        ts.tv_nsec = due % 1000000000LL;
+        pthread_cond_timedwait(&tp->cond, &tp->lock, &ts);
+    }
+    pthread_mutex_unlock(&tp->lock);
+    return NULL;
+}
+
+int threads_start(const PlayerData init[], int n, const PlayerParams *pp,
+                  SharedState *clock_region, StatCounters *counters, const Tuning *tuning_in)
+{
+    if (tuning_in) {
+        tuning = *tuning_in;
+        tuned = 1;
+    }
+    reply_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reply_fd == -1) {
+        perror("eventfd failed");
+        return -1;
+    }
+
+    tps = calloc(n, sizeof(ThreadPlayer));
+    if (!tps) {
+        perror("calloc player threads failed");
+        return -1;
+    }
+    n_players = n;
+    shared = clock_region;
+
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+
+    for (int i = 0; i < n; i++) {
+        ThreadPlayer *tp = &tps[i];
+        tp->index = i;
+        tp->stats = &counters[i];
+        tp->me = init[i];
+        tp->key = rng_key(shared->game_seed, i);
+        tp->params = *pp;
+        tp->game = atomic_load(&shared->game);
+        pthread_mutex_init(&tp->lock, NULL);
+        pthread_cond_init(&tp->cond, &ca);
+        publish_slot(tp, 0);
+
+        if (pthread_create(&tp->thread, NULL, player_main, tp) != 0) {
+            perror("pthread_create player failed");
+            return -1;
+        }
+    }
+    pthread_condattr_destroy(&ca);
+    return 0;
+}
+
+int threads_fd(void)
+{
+    return reply_fd;
+}
+
+void threads_send(int i, int sig, int arg)
+{
+    ThreadPlayer *tp = &tps[i];
+
+    pthread_mutex_lock(&tp->lock);
+    if (tp->count == CMD_QUEUE_SIZE) {
+        fprintf(stderr, "[PARENT] Command queue of player %d full, dropping\n", i);
+    } else {
+        PlayerCommand *c = &tp->cmds[(tp->head + tp->count) % CMD_QUEUE_SIZE];
+        c->sig = sig;
+        c->arg = arg;
+        tp->count++;
+        pthread_cond_signal(&tp->cond);
+    }
+    pthread_mutex_unlock(&tp->lock);
+}
+
+int threads_drain(ThreadReply *out, int max)
+{
+    uint64_t pending;
+    if (read(reply_fd, &pending, sizeof(pending)) == -1 && errno != EAGAIN)
+        perror("eventfd read failed");
+
+    pthread_mutex_lock(&reply_lock);
+    int n = reply_count < max ? reply_count : max;
+    for (int k = 0; k < n; k++) {
+        out[k] = replies[reply_head];
+        reply_head = (reply_head + 1) % REPLY_QUEUE_SIZE;
+    }
+    reply_count -= n;
+    if (n > 0)
+        pthread_cond_broadcast(&reply_space);
+    pthread_mutex_unlock(&reply_lock);
+    return n;
+}
+
+void threads_stop(void)
+{
+    for (int i = 0; i < n_players; i++) {
+        threads_send(i, SIG_TERMINATE, 0);
+    }
+    for (int i = 0; i < n_players; i++) {
+        pthread_join(tps[i].thread, NULL);
+        pthread_mutex_destroy(&tps[i].lock);
+        pthread_cond_destroy(&tps[i].cond);
+    }
+    free(tps);
+    tps = NULL;
+    n_players = 0;
+    close(reply_fd);
+    reply_fd = -1;
+}
@@ -0,0 +1,42 @@
+// player_thread.h
+#ifndef PLAYER_THREAD_H
+#define PLAYER_THREAD_H
+
+#include "constant.h"
+#include "player_logic.h"
+#include "shm.h"
+#include "stats.h"
+#include "tuning.h"
+
+// In-process player engine: each player is a thread running player_logic.c.
+// The referee sends the same SIG_* codes as to player processes, but through
+// per-player command queues, and the players answer through one reply queue
+// whose eventfd wakes the referee's epoll loop.
+
+// One record from a player thread, as a player process writes it to its
+// effort pipe
+typedef struct {
+    int index;                        // referee index of the player
+    TickRecord rec;
+} ThreadReply;
+
+// Start n player threads with their initial state. Ticks are scheduled
+// against the round clock in shared and draw from shared->game_seed, like
+// the player processes. Player i keeps its stats in counters[i]. Each
+// thread applies tuning to itself first, NULL => none.
+int threads_start(const PlayerData init[], int n, const PlayerParams *pp,
+                  SharedState *shared, StatCounters *counters, const Tuning *tuning);
+
+// Readable when replies are waiting
+int threads_fd(void);
+
+// Deliver a SIG_* command to player i, arg is the location for SIG_SET_LOC
+void threads_send(int i, int sig, int arg);
+
+// Take up to max pending replies => number taken
+int threads_drain(ThreadReply *out, int max);
+
+// SIG_TERMINATE every player and join the threads
+void threads_stop(void);
+
+#endif
@@ -0,0 +1,196 @@
+// ranking.c
+#include <stdlib.h>
+#include <string.h>
+#include "ranking.h"
+
+// More than n / RESORT_SHARE changed energies in a batch, or more than
+// n * SHIFT_BUDGET members shifted while moving them one by one => sort
+// the team again instead
+#define RESORT_SHARE  8
+#define SHIFT_BUDGET  4
+
+#define RANK_CHANGED  1   // in changed[]
+#define RANK_MOVED    2   // in moved[]
+
+int ranking_init(Ranking *r, int n)
+{
+    memset(r, 0, sizeof(*r));
+    r->n = n;
+    r->order = calloc(n, sizeof(int));
+    r->pos = calloc(n, sizeof(int));
+    r->key = calloc(n, sizeof(int));
+    r->given = calloc(n, sizeof(int));
+    r->next_key = calloc(n, sizeof(int));
+    r->changed = calloc(n, sizeof(int));
+    r->moved = calloc(n, sizeof(int));
+    r->flags = calloc(n, sizeof(char));
+    r->scratch = calloc(n, sizeof(RankEntry));
+    if (!r->order || !r->pos || !r->key || !r->given || !r->next_key || !r->changed ||
+        !r->moved || !r->flags || !r->scratch) {
+        ranking_free(r);
+        return -1;
+    }
+    for (int m = 0; m < n; m++) {
+        r->order[m] = m;
+        r->pos[m] = m;
+        r->given[m] = m;
+    }
+    return 0;
+}
+
+void ranking_free(Ranking *r)
+{
+    free(r->order);
+    free(r->pos);
+    free(r->key);
+    free(r->given);
+    free(r->next_key);
+    free(r->changed);
+    free(r->moved);
+    free(r->flags);
+    free(r->scratch);
+    memset(r, 0, sizeof(*r));
+}
+
+/**
+ * Sort every member by r->key into order/pos
+ */
+static void sort_members(Ranking *r)
+{
+    for (int m = 0; m < r->n; m++) {
+        r->scratch[m].index = m;
+        r->scratch[m].energy = r->key[m];
+    }
+    rank_by_energy(r->scratch, r->n);
+
+    for (int k = 0; k < r->n; k++) {
+        r->order[k] = r->scratch[k].index;
+        r->pos[r->order[k]] = k;
+    }
+}
+
+void ranking_build(Ranking *r, const int key[])
+{
+    memcpy(r->key, key, r->n * sizeof(int));
+    sort_members(r);
+    memcpy(r->given, r->pos, r->n * sizeof(int));
+    memset(r->flags, 0, r->n);
+    r->n_changed = 0;
+    r->n_moved = 0;
+}
+
+void ranking_update(Ranking *r, int m, int key)
+{
+    r->next_key[m] = key;
+    if (!(r->flags[m] & RANK_CHANGED)) {
+        r->flags[m] |= RANK_CHANGED;
+        r->changed[r->n_changed++] = m;
+    }
+}
+
+/**
+ * Member a goes before member b
+ */
+static int ranks_before(const Ranking *r, int a, int b)
+{
+    if (r->key[a] != r->key[b])
+        return r->key[a] > r->key[b];
+    return a < b;
+}
+
+/**
+ * Put member m at location k, the others already made room
+ */
+static void place(Ranking *r, int m, int k)
+{
+    r->order[k] = m;
+    r->pos[m] = k;
+    if (!(r->flags[m] & RANK_MOVED)) {
+        r->flags[m] |= RANK_MOVED;
+        r->moved[r->n_moved++] = m;
+    }
+}
+
+/**
+ * Member m got a new key: move it to its place in the sorted order
+ * => number of members that shifted
+ */
+static int reposition(Ranking *r, int m)
+{
+    int p = r->pos[m];
+
+    if (p > 0 && ranks_before(r, m, r->order[p - 1])) {
+        // Up: first location in [0, p) whose member m goes before
+        int lo = 0, hi = p - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (ranks_before(r, m, r->order[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        for (int k = p; k > lo; k--)
+            place(r, r->order[k - 1], k);
+        place(r, m, lo);
+        return p - lo;
+    } else if (p < r->n - 1 && ranks_before(r, r->order[p + 1], m)) {
+        // Down: last location in (p, n) whose member goes before m
+        int lo = p + 1, hi = r->n - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo + 1) / 2;
+            if (ranks_before(r, r->order[mid], m))
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        for (int k = p; k < lo; k++)
+            place(r, r->order[k + 1], k);
+        place(r, m, lo);
+        return lo - p;
+    }
+    return 0;
+}
+
+int ranking_take_moved(Ranking *r)
+{
+    int resort = r->n_changed > r->n / RESORT_SHARE;
+    long long shifts = 0, budget = (long long)r->n * SHIFT_BUDGET;
+    int changed = 0;
+    for (int k = 0; k < r->n_changed; k++) {
+        int m = r->changed[k];
+        r->flags[m] &= ~RANK_CHANGED;
+        if (r->key[m] == r->next_key[m])
+            continue;
+        r->key[m] = r->next_key[m];
+        changed++;
+        if (!resort) {
+            // Far moves: the sort below is cheaper for the rest
+            shifts += reposition(r, m);
+            resort = shifts > budget;
+        }
+    }
+    r->n_changed = 0;
+
+    if (resort && changed > 0) {
+        sort_members(r);
+        for (int m = 0; m < r->n; m++) {
+            if (r->pos[m] != r->given[m] && !(r->flags[m] & RANK_MOVED)) {
+                r->flags[m] |= RANK_MOVED;
+                r->moved[r->n_moved++] = m;
+            }
+        }
+    }
+
+    int count = 0;
+    for (int k = 0; k < r->n_moved; k++) {
+        int m = r->moved[k];
+        r->flags[m] &= ~RANK_MOVED;
+        // Moved and back again within the batch => nothing to send
+        if (r->pos[m] == r->given[m])
+            continue;
+        r->given[m] = r->pos[m];
+        r->moved[count++] = m;
+    }
+    r->n_moved = 0;
+    return count;
+}
@@ -0,0 +1,49 @@
+// ranking.h
+#ifndef RANKING_H
+#define RANKING_H
+
+#include "game_rules.h"
+
+// Location ranking of one team that follows live energies. Members are
+// kept sorted by the same order as rank_by_energy() (highest energy first,
+// lower member first on a tie), so location k is simply order[k].
+//
+// New energies are collected per tick. When few members changed, each one
+// is moved by binary search to its new place and the members in between
+// shift by one: O(log n) plus one step per member that really changes
+// location. When many changed, one sort of the team is cheaper than all
+// those shifts and gives the same order. Either way only the members whose
+// location differs from the last one they were given come out.
+typedef struct {
+    int n;
+    int *order;      // order[k] = member at location k
+    int *pos;        // pos[m] = location of member m
+    int *key;        // energy member m is ranked by
+    int *given;      // location member m was last given
+    int *next_key;   // energy of a changed member, not ranked yet
+    int *changed;    // members with a next_key
+    int n_changed;
+    int *moved;      // members whose location may differ from given
+    int n_moved;
+    char *flags;     // RANK_CHANGED | RANK_MOVED per member
+    RankEntry *scratch;
+} Ranking;
+
+// Allocate a ranking of n members => 0, or -1 if out of memory
+int ranking_init(Ranking *r, int n);
+void ranking_free(Ranking *r);
+
+// Rank every member from scratch by key[m]. The new locations count as
+// given: the caller sends all of them.
+void ranking_build(Ranking *r, const int key[]);
+
+// Member m now has energy key, ranked at the next ranking_take_moved()
+void ranking_update(Ranking *r, int m, int key);
+
+// Rank the energies of the ranking_update() calls so far and collect the
+// members whose location differs from the one they were last given
+// => count, the members are r->moved[0, count). Their location r->pos[m]
+// counts as given from now on.
+int ranking_take_moved(Ranking *r);
+
+#endif
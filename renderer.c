@@ -0,0 +1,347 @@
+// renderer.c
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <math.h>
+#include <stdio.h>
+#include <stddef.h>
+#include "renderer.h"
+
+// Parts of the player figure, each has its own color rule in the shader
+#define PART_HEAD    0   // skin, gray once the energy is gone
+#define PART_BLACK   1   // eyes, arms, legs
+#define PART_BODY    2   // team color
+#define PART_BAR_BG  3   // energy bar background
+#define PART_BAR     4   // energy bar, as long as the energy
+
+// One pixel of the 800x600 window in clip space, for the figure's lines
+#define PIXEL_W  0.0025f
+#define PIXEL_H  0.0034f
+
+// Vertex of the player figure: x = x + arm * facing + bar * energy ratio
+typedef struct {
+    float x, y;
+    float part;
+    float arm;     // arm tips follow the facing
+    float bar;     // right edge of the energy bar follows the energy
+} FigureVertex;
+
+typedef struct {
+    float x, y;
+    float r, g, b;
+} SceneVertex;
+
+// Head fan as triangles, eyes, body, arms, legs, bar
+#define FIGURE_VERTICES  (CIRCLE_SEGMENTS * 3 + 9 * 6)
+#define FAN_VERTICES     (CIRCLE_SEGMENTS + 2)
+#define SCENE_VERTICES   (6 + 4 * FAN_VERTICES + 6)
+
+static GLuint figure_program, scene_program;
+static GLuint figure_vao, scene_vao;
+static GLuint figure_vbo, scene_vbo, instance_vbo;
+static GLint bob_uniform, offset_uniform;
+static GLsizeiptr instance_cap = 0;   // bytes allocated in instance_vbo
+
+// Ranges of the scene buffer
+static GLint sky_first, sun_first, cloud_first, rope_first;
+
+static const char *figure_vs =
+    "#version 330\n"
+    "layout(location = 0) in vec2 a_pos;\n"
+    "layout(location = 1) in vec3 a_part;\n"    // part, arm, bar
+    "layout(location = 2) in vec2 i_base;\n"
+    "layout(location = 3) in vec3 i_color;\n"
+    "layout(location = 4) in vec3 i_state;\n"   // energy, phase, facing
+    "uniform vec2 u_bob;\n"                     // frame, 1 => bobbing
+    "out vec3 v_color;\n"
+    "void main() {\n"
+    "    float energy = i_state.x;\n"
+    "    float ratio = clamp(energy / 100.0, 0.0, 1.0);\n"
+    "    vec2 p = vec2(a_pos.x + a_part.y * i_state.z + a_part.z * ratio, a_pos.y);\n"
+    "    p.y += u_bob.y * 0.005 * sin(u_bob.x + i_state.y);\n"
+    "    int part = int(a_part.x + 0.5);\n"
+    "    if (part == 0)\n"
+    "        v_color = energy <= 0.1 ? vec3(0.6) : vec3(1.0, 0.8, 0.6);\n"
+    "    else if (part == 1)\n"
+    "        v_color = vec3(0.0);\n"
+    "    else if (part == 2)\n"
+    "        v_color = i_color;\n"
+    "    else if (part == 3)\n"
+    "        v_color = vec3(0.8);\n"
+    "    else\n"
+    "        v_color = vec3(0.0, 1.0, 0.0);\n"
+    "    gl_Position = vec4(i_base + p, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *scene_vs =
+    "#version 330\n"
+    "layout(location = 0) in vec2 a_pos;\n"
+    "layout(location = 1) in vec3 a_color;\n"
+    "uniform vec2 u_offset;\n"
+    "out vec3 v_color;\n"
+    "void main() {\n"
+    "    v_color = a_color;\n"
+    "    gl_Position = vec4(a_pos + u_offset, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *color_fs =
+    "#version 330\n"
+    "in vec3 v_color;\n"
+    "out vec4 frag;\n"
+    "void main() {\n"
+    "    frag = vec4(v_color, 1.0);\n"
+    "}\n";
+
+unsigned int renderer_program(const char *vs_src, const char *fs_src)
+{
+    const char *srcs[2] = { vs_src, fs_src };
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    char log[1024];
+    GLint ok;
+
+    GLuint prog = glCreateProgram();
+    for (int k = 0; k < 2; k++) {
+        GLuint sh = glCreateShader(types[k]);
+        glShaderSource(sh, 1, &srcs[k], NULL);
+        glCompileShader(sh);
+        glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            glGetShaderInfoLog(sh, sizeof(log), NULL, log);
+            fprintf(stderr, "Shader compile failed: %s\n", log);
+            glDeleteShader(sh);
+            glDeleteProgram(prog);
+            return 0;
+        }
+        glAttachShader(prog, sh);
+        glDeleteShader(sh);   // freed with the program
+    }
+    glLinkProgram(prog);
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        glGetProgramInfoLog(prog, sizeof(log), NULL, log);
+        fprintf(stderr, "Shader link failed: %s\n", log);
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+static void figure_quad(FigureVertex **v, float x0, float y0, float x1, float y1, int part,
+                        float arm0, float arm1, float bar1)
+{
+    FigureVertex q[4] = {
+        { x0, y0, part, arm0, 0 }, { x1, y0, part, arm1, bar1 },
+        { x1, y1, part, arm1, bar1 }, { x0, y1, part, arm0, 0 }
+    };
+    static const int tri[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int k = 0; k < 6; k++)
+        *(*v)++ = q[tri[k]];
+}
+
+/**
+ * The figure of drawPlayer() in graphics.c, lines and points as one pixel
+ * wide quads, relative to the player's base
+ */
+static void build_figure(FigureVertex *v)
+{
+    for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+        float a0 = 2.0f * (float)M_PI * i / CIRCLE_SEGMENTS;
+        float a1 = 2.0f * (float)M_PI * (i + 1) / CIRCLE_SEGMENTS;
+        *v++ = (FigureVertex){ 0, 0, PART_HEAD, 0, 0 };
+        *v++ = (FigureVertex){ 0.02f * cosf(a0), 0.02f * sinf(a0), PART_HEAD, 0, 0 };
+        *v++ = (FigureVertex){ 0.02f * cosf(a1), 0.02f * sinf(a1), PART_HEAD, 0, 0 };
+    }
+    // Eyes
+    figure_quad(&v, -0.007f, 0.01f, -0.007f + PIXEL_W, 0.01f + PIXEL_H, PART_BLACK, 0, 0, 0);
+    figure_quad(&v, 0.007f, 0.01f, 0.007f + PIXEL_W, 0.01f + PIXEL_H, PART_BLACK, 0, 0, 0);
+    // Body
+    figure_quad(&v, -0.02f, -0.02f, 0.02f, -0.08f, PART_BODY, 0, 0, 0);
+    // Arms: from the shoulder to 0.06 on the facing side
+    figure_quad(&v, -0.02f, -0.04f, 0, -0.04f + PIXEL_H, PART_BLACK, 0, -0.06f, 0);
+    figure_quad(&v, 0.02f, -0.04f, 0, -0.04f + PIXEL_H, PART_BLACK, 0, 0.06f, 0);
+    // Legs
+    figure_quad(&v, -0.01f, -0.08f, -0.01f + PIXEL_W, -0.11f, PART_BLACK, 0, 0, 0);
+    figure_quad(&v, 0.01f, -0.08f, 0.01f + PIXEL_W, -0.11f, PART_BLACK, 0, 0, 0);
+    // Energy bar, the fill grows to 0.04 at full energy
+    figure_quad(&v, -0.02f, -0.12f, 0.02f, -0.13f, PART_BAR_BG, 0, 0, 0);
+    figure_quad(&v, -0.02f, -0.12f, -0.02f, -0.13f, PART_BAR, 0, 0, 0.04f);
+}
+
+static SceneVertex *scene_fan(SceneVertex *v, float cx, float cy, float rx, float ry,
+                              float r, float g, float b)
+{
+    *v++ = (SceneVertex){ cx, cy, r, g, b };
+    for (int i = 0; i <= CIRCLE_SEGMENTS; i++) {
+        float a = 2.0f * (float)M_PI * i / CIRCLE_SEGMENTS;
+        *v++ = (SceneVertex){ cx + rx * cosf(a), cy + ry * sinf(a), r, g, b };
+    }
+    return v;
+}
+
+static SceneVertex *scene_quad(SceneVertex *v, float x0, float y0, float x1, float y1,
+                               const float top[3], const float bottom[3])
+{
+    SceneVertex q[4] = {
+        { x0, y0, top[0], top[1], top[2] }, { x1, y0, top[0], top[1], top[2] },
+        { x1, y1, bottom[0], bottom[1], bottom[2] }, { x0, y1, bottom[0], bottom[1], bottom[2] }
+    };
+    static const int tri[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int k = 0; k < 6; k++)
+        *v++ = q[tri[k]];
+    return v;
+}
+
+/**
+ * Sky, sun, the three puffs of the cloud at x = 0, rope at offset 0
+ */
+static void build_scene(SceneVertex *v)
+{
+    static const float sky[3] = { 0.6f, 0.85f, 1.0f }, grass[3] = { 0.3f, 0.7f, 0.3f };
+    static const float rope[3] = { 0.4f, 0.2f, 0.0f };
+    SceneVertex *start = v;
+
+    sky_first = v - start;
+    v = scene_quad(v, -1.0f, 1.0f, 1.0f, -1.0f, sky, grass);
+    sun_first = v - start;
+    v = scene_fan(v, -0.85f, 0.85f, 0.08f, 0.08f, 1.0f, 1.0f, 0.0f);
+    cloud_first = v - start;
+    for (int i = -1; i <= 1; i++)
+        v = scene_fan(v, i * 0.05f, 0.85f, 0.04f, 0.03f, 1.0f, 1.0f, 1.0f);
+    rope_first = v - start;
+    v = scene_quad(v, -0.9f, -0.01f, 0.9f, 0.01f, rope, rope);
+}
+
+int renderer_init(void)
+{
+    int major = 0, minor = 0;
+    const char *version = (const char *)glGetString(GL_VERSION);
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 ||
+        major * 10 + minor < 33) {
+        fprintf(stderr, "OpenGL %s: no instanced renderer, drawing in immediate mode\n",
+                version ? version : "?");
+        return -1;
+    }
+    figure_program = renderer_program(figure_vs, color_fs);
+    scene_program = renderer_program(scene_vs, color_fs);
+    if (!figure_program || !scene_program)
+        return -1;
+    bob_uniform = glGetUniformLocation(figure_program, "u_bob");
+    offset_uniform = glGetUniformLocation(scene_program, "u_offset");
+
+    FigureVertex figure[FIGURE_VERTICES];
+    SceneVertex scene[SCENE_VERTICES];
+    build_figure(figure);
+    build_scene(scene);
+
+    GLuint vaos[2], vbos[3];
+    glGenVertexArrays(2, vaos);
+    glGenBuffers(3, vbos);
+    figure_vao = vaos[0];
+    scene_vao = vaos[1];
+    figure_vbo = vbos[0];
+    scene_vbo = vbos[1];
+    instance_vbo = vbos[2];
+
+    // Figure: per-vertex mesh + per-instance PlayerInstance
+    glBindVertexArray(figure_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, figure_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(figure), figure, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(FigureVertex),
+                          (void *)offsetof(FigureVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(FigureVertex),
+                          (void *)offsetof(FigureVertex, part));
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(PlayerInstance),
+                          (void *)offsetof(PlayerInstance, x));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(PlayerInstance),
+                          (void *)offsetof(PlayerInstance, r));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(PlayerInstance),
+                          (void *)offsetof(PlayerInstance, energy));
+    for (int k = 2; k <= 4; k++)
+        glVertexAttribDivisor(k, 1);
+
+    // Scenery
+    glBindVertexArray(scene_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, scene_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(scene), scene, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SceneVertex),
+                          (void *)offsetof(SceneVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SceneVertex),
+                          (void *)offsetof(SceneVertex, r));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR) {
+        fprintf(stderr, "Instanced renderer setup failed, drawing in immediate mode\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Back to the fixed pipeline for the immediate-mode text drawn after us
+ */
+static void renderer_done(void)
+{
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+void renderer_draw_scenery(float cloud_x)
+{
+    static const GLint puff_first[3] = { 0, FAN_VERTICES, 2 * FAN_VERTICES };
+    static const GLsizei puff_count[3] = { FAN_VERTICES, FAN_VERTICES, FAN_VERTICES };
+    GLint first[3];
+
+    glUseProgram(scene_program);
+    glBindVertexArray(scene_vao);
+    glUniform2f(offset_uniform, 0.0f, 0.0f);
+    glDrawArrays(GL_TRIANGLES, sky_first, 6);
+    glDrawArrays(GL_TRIANGLE_FAN, sun_first, FAN_VERTICES);
+    glUniform2f(offset_uniform, cloud_x, 0.0f);
+    for (int k = 0; k < 3; k++)
+        first[k] = cloud_first + puff_first[k];
+    glMultiDrawArrays(GL_TRIANGLE_FAN, first, puff_count, 3);
+    renderer_done();
+}
+
+void renderer_draw_rope(float offset)
+{
+    glUseProgram(scene_program);
+    glBindVertexArray(scene_vao);
+    glUniform2f(offset_uniform, offset, 0.0f);
+    glDrawArrays(GL_TRIANGLES, rope_first, 6);
+    renderer_done();
+}
+
+void renderer_draw_players(const PlayerInstance *players, int n, float bob_frame, int bobbing)
+{
+    if (n <= 0)
+        return;
+    GLsizeiptr size = (GLsizeiptr)n * sizeof(PlayerInstance);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    if (size > instance_cap) {
+        glBufferData(GL_ARRAY_BUFFER, size, players, GL_STREAM_DRAW);
+        instance_cap = size;
+    } else {
+        // Orphan last frame's storage rather than wait for the GPU to drop it
+        glBufferData(GL_ARRAY_BUFFER, instance_cap, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, players);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(figure_program);
+    glBindVertexArray(figure_vao);
+    glUniform2f(bob_uniform, bob_frame, bobbing ? 1.0f : 0.0f);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, FIGURE_VERTICES, n);
+    renderer_done();
+}
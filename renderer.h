@@ -0,0 +1,41 @@
+// renderer.h
+#ifndef RENDERER_H
+#define RENDERER_H
+
+// Retained-mode renderer of graphics.c: the scenery and the player figure
+// are uploaded once into vertex buffers, and every player of every team is
+// drawn by one instanced draw from a small per-player instance buffer.
+// Needs OpenGL 3.3 (Mesa's llvmpipe has it); without it graphics.c keeps
+// drawing in immediate mode.
+
+// Segments of every circle, in both renderers
+#define CIRCLE_SEGMENTS 64
+
+// One player as the instanced draw sees it
+typedef struct {
+    float x, y;          // base of the figure
+    float r, g, b;       // body (team) color
+    float energy;        // energy shown by the bar, <= 0.1 grays the head out
+    float phase;         // bob phase, added to the frame's bob angle
+    float facing;        // 1 => arms pointing right, -1 => pointing left
+} PlayerInstance;
+
+// Set up the buffers and shaders in the current GL context => 0, or -1 if
+// the context can't run them (the caller falls back to immediate mode)
+int renderer_init(void);
+
+// Compile and link a GLSL 3.30 program => program, or 0 (the log goes to
+// stderr). Only after renderer_init() succeeded.
+unsigned int renderer_program(const char *vs_src, const char *fs_src);
+
+// Sky, sun, and the cloud moved right by cloud_x
+void renderer_draw_scenery(float cloud_x);
+
+// Rope moved right by offset
+void renderer_draw_rope(float offset);
+
+// n players in one instanced draw. While bobbing, each figure moves up and
+// down with sin(bob_frame + its phase).
+void renderer_draw_players(const PlayerInstance *players, int n, float bob_frame, int bobbing);
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * Rope Pulling Game - Replay
+ * Re-drives the scoring rules (game_rules.c) and the graphics feed from a
+ * log written by `rope_game --record <file>`, without any player process
+ *
+ * Every recorded decision (tick winners, end conditions, game winner) is
+ * checked against what the rules compute from the recorded inputs, so a
+ * replay also tells whether the scoring was consistent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "constant.h"
+#include "config.h"
+#include "game_rules.h"
+#include "game_state.h"
+#include "loop.h"
+#include "replay_log.h"
+
+static GameConfig cfg;
+static int num_teams, team_size, n_players;
+
+// State rebuilt from the log
+static int *energy;             // last raw energy of each player
+static int *location;           // last location of each player
+static int *slot_sum;           // shm mode: last effort sum of each slot
+static int *slot_round;         // and the round it belongs to
+static int team_sums[MAX_TEAMS];
+static MatchScore match;
+static int mismatches = 0;
+
+// Graphics feed (--graphics)
+static GameState *game_state = NULL;
+static GraphicsMessage *graphics_msg;
+static long long graphics_tick_ns = 0;  // replayed tick period, 0 => not paced
+static int last_tick = 0;               // of the round being replayed
+
+/**
+ * Start ./graphics on a fresh GameState page
+ */
+static int start_graphics(void)
+{
+    int fd;
+    game_state = game_state_create(num_teams, team_size, &fd);
+    if (!game_state)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        fcntl(fd, F_SETFD, 0);   // keep the page across exec
+        char fd_str[16];
+        sprintf(fd_str, "%d", fd);
+        execl("./graphics", "./graphics", "--shm", fd_str, (char*)NULL);
+        perror("execl graphics failed");
+        exit(1);
+    } else if (pid == -1) {
+        perror("fork failed for graphics process");
+        return -1;
+    }
+    printf("[REPLAY] Spawned graphics process with PID %d\n", pid);
+    return 0;
+}
+
+/**
+ * Publish the round state to graphics, as the referee does after a tick
+ */
+static void publish_round(int round, int winner, int tick)
+{
+    if (!game_state)
+        return;
+    graphics_msg->roundNumber = round;
+    graphics_msg->numTeams = num_teams;
+    graphics_msg->teamSize = team_size;
+    graphics_msg->roundWinner = winner;
+    graphics_msg->tick = tick;
+    graphics_msg->stateNs = mono_ns();
+    graphics_msg->tickNs = graphics_tick_ns;
+    memcpy(graphics_sums(graphics_msg), team_sums, num_teams * sizeof(int));
+    int *energies = graphics_energies(graphics_msg);
+    for (int i = 0; i < n_players; i++) {
+        energies[i] = energy[i] / (location[i] + 1);
+    }
+    game_state_publish(game_state, graphics_msg);
+}
+
+static void mismatch(const ReplayRecord *r, const char *what, int recorded, int computed)
+{
+    mismatches++;
+    printf("[REPLAY] Round %d, tick %d: %s recorded %d, rules give %d\n",
+           r->round, r->tick, what, recorded, computed);
+}
+
+/**
+ * Apply one record
+ */
+static void replay_record(const ReplayRecord *r)
+{
+    switch (r->type) {
+    case REC_GAME_START:
+        match_init(&match, num_teams);
+        break;
+    case REC_CONFIG:
+        printf("[REPLAY] Round %d: %s = %d\n", r->round, config_live_name(r->a), r->b);
+        *config_live_value(&cfg, r->a) = r->b;
+        break;
+    case REC_ROUND_START:
+        printf("\n===== START ROUND %d =====\n", r->round);
+        memset(team_sums, 0, sizeof(team_sums));
+        last_tick = 0;
+        publish_round(r->round, 0, 0);
+        break;
+    case REC_ENERGY:
+        energy[r->player] = r->a;
+        location[r->player] = r->b;
+        break;
+    case REC_EFFORT:
+        team_sums[r->player / team_size] += r->a;
+        break;
+    case REC_SLOT:
+        slot_sum[r->player] = r->a;
+        slot_round[r->player] = r->round;
+        location[r->player] = r->b;
+        energy[r->player] = r->c;
+        break;
+    case REC_LOCATION:
+        location[r->player] = r->a;
+        break;
+    case REC_TICK: {
+        if (cfg.ipc_mode == IPC_SHM) {
+            // The referee sums the latest slot of every player
+            memset(team_sums, 0, sizeof(team_sums));
+            for (int i = 0; i < n_players; i++) {
+                if (slot_round[i] == r->round)
+                    team_sums[i / team_size] += slot_sum[i];
+            }
+        }
+        printf("[Round %d, tick %d]", r->round, r->tick);
+        for (int t = 0; t < num_teams; t++) {
+            printf("%s T%d=%d", t ? "," : "", t + 1, team_sums[t]);
+        }
+        printf("\n");
+
+        int time_up;
+        int winner = round_check(&cfg, team_sums, r->a, &time_up);
+        if (winner != r->b)
+            mismatch(r, "tick winner", r->b, winner);
+        last_tick = r->tick;
+        publish_round(r->round, 0, last_tick);
+        break;
+    }
+    case REC_ROUND_END: {
+        printf("=== Winner of round %d is Team %d ===\n", r->round, r->a + 1);
+        publish_round(r->round, r->a + 1, last_tick);
+        match_record(&match, r->a);
+        int end_reason = match_check(&match, &cfg, r->a, r->c);
+        if (end_reason != r->b)
+            mismatch(r, "end condition", r->b, end_reason);
+        break;
+    }
+    case REC_GAME_END: {
+        int winner = match_winner(&match);
+        if (winner != r->a)
+            mismatch(r, "game winner", r->a, winner);
+        if (game_state) {
+            graphics_msg->roundNumber = -1;
+            graphics_msg->numTeams = num_teams;
+            graphics_msg->teamSize = 0;
+            graphics_msg->roundWinner = r->a;
+            graphics_msg->stateNs = mono_ns();
+            memcpy(graphics_sums(graphics_msg), match.team_scores, num_teams * sizeof(int));
+            game_state_publish(game_state, graphics_msg);
+        }
+        break;
+    }
+    default:
+        fprintf(stderr, "[REPLAY] Unknown record type %d\n", r->type);
+        break;
+    }
+}
+
+/**
+ * Sleep until the absolute monotonic deadline
+ */
+static void sleep_until(long long deadline_ns)
+{
+    struct timespec ts;
+    ts.tv_sec = deadline_ns / 1000000000LL;
+    ts.tv_nsec = deadline_ns % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+int main(int argc, char *argv[])
+{
+    double speed = 0.0;          // 0 => as fast as possible
+    int graphics = 0;
+    const char *log_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--graphics") == 0) {
+            graphics = 1;
+        } else if (argv[i][0] != '-' && !log_path) {
+            log_path = argv[i];
+        } else {
+            log_path = NULL;
+            break;
+        }
+    }
+    if (!log_path || speed < 0) {
+        fprintf(stderr, "Usage: %s [--speed X] [--graphics] <log_file>\n"
+                "  --speed X   X times real time, 0 (default) as fast as possible\n", argv[0]);
+        return 1;
+    }
+
+    ReplayHeader hdr;
+    size_t count;
+    const ReplayRecord *recs = replay_load(log_path, &hdr, &count);
+    if (!recs) {
+        return 1;
+    }
+    cfg = hdr.cfg;
+    num_teams = cfg.num_teams;
+    team_size = cfg.team_size;
+    n_players = num_teams * team_size;
+
+    energy = calloc(n_players, sizeof(int));
+    location = calloc(n_players, sizeof(int));
+    slot_sum = calloc(n_players, sizeof(int));
+    slot_round = calloc(n_players, sizeof(int));
+    graphics_msg = calloc(1, GRAPHICS_MSG_SIZE(num_teams, team_size));
+    if (!energy || !location || !slot_sum || !slot_round || !graphics_msg) {
+        perror("calloc failed");
+        return 1;
+    }
+    if (speed > 0)
+        graphics_tick_ns = (long long)(1e9 / cfg.tick_hz / speed);
+    if (graphics && start_graphics() != 0) {
+        return 1;
+    }
+
+    printf("[REPLAY] %zu records, %d teams x %d players, tick_hz=%d, seed=%u\n",
+           count, num_teams, team_size, cfg.tick_hz, hdr.seed);
+
+    long long start = mono_ns();
+    for (size_t k = 0; k < count; k++) {
+        const ReplayRecord *r = &recs[k];
+        int per_player = r->type == REC_ENERGY || r->type == REC_EFFORT ||
+                         r->type == REC_SLOT || r->type == REC_LOCATION;
+        if (per_player && (r->player < 0 || r->player >= n_players)) {
+            fprintf(stderr, "[REPLAY] Record %zu: bad player %d\n", k, r->player);
+            return 1;
+        }
+        if (r->type == REC_ROUND_END && (r->a < 0 || r->a >= num_teams)) {
+            fprintf(stderr, "[REPLAY] Record %zu: bad winning team %d\n", k, r->a);
+            return 1;
+        }
+        if (r->type == REC_CONFIG && !config_live_valid(r->a, r->b)) {
+            fprintf(stderr, "[REPLAY] Record %zu: bad config key %d = %d\n", k, r->a, r->b);
+            return 1;
+        }
+        // A reload changes a min/max pair one key at a time, the round
+        // starts with both
+        if (r->type == REC_ROUND_START && !config_live_consistent(&cfg)) {
+            fprintf(stderr, "[REPLAY] Record %zu: config ranges out of order\n", k);
+            return 1;
+        }
+        if (speed > 0)
+            sleep_until(start + (long long)(r->time_ns / speed));
+        replay_record(r);
+    }
+
+    printf("\n==== Final Score ====\n");
+    for (int t = 0; t < num_teams; t++) {
+        printf("%sTeam%d=%d", t ? ", " : "", t + 1, match.team_scores[t]);
+    }
+    printf("\n");
+    if (mismatches == 0) {
+        printf("[REPLAY] Every recorded decision matches the rules\n");
+    } else {
+        printf("[REPLAY] %d recorded decisions differ from the rules\n", mismatches);
+    }
+    return mismatches ? 2 : 0;
+}
@@ -0,0 +1,159 @@
+// replay_log.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "constant.h"
+#include "loop.h"
+#include "replay_log.h"
+
+#define REPLAY_INITIAL_SIZE (4 << 20)
+
+_Static_assert(sizeof(ReplayHeader) <= REPLAY_HEADER_SIZE, "replay header too large");
+_Static_assert(sizeof(ReplayRecord) == 32, "replay records are 32 bytes");
+
+int replay_open(ReplayLog *log, const char *path, const GameConfig *cfg, uint32_t seed)
+{
+    log->base = NULL;
+    log->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (log->fd == -1) {
+        perror("open replay log failed");
+        return -1;
+    }
+    if (ftruncate(log->fd, REPLAY_INITIAL_SIZE) == -1) {
+        perror("ftruncate replay log failed");
+        close(log->fd);
+        return -1;
+    }
+    char *p = mmap(NULL, REPLAY_INITIAL_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap replay log failed");
+        close(log->fd);
+        return -1;
+    }
+
+    ReplayHeader *hdr = (ReplayHeader *)p;
+    memcpy(hdr->magic, REPLAY_MAGIC, sizeof(hdr->magic));
+    hdr->version = REPLAY_VERSION;
+    hdr->header_size = REPLAY_HEADER_SIZE;
+    hdr->records = 0;
+    hdr->cfg = *cfg;
+    hdr->seed = seed;
+
+    log->base = p;
+    log->cap = REPLAY_INITIAL_SIZE;
+    log->used = REPLAY_HEADER_SIZE;
+    log->t0_ns = mono_ns();
+    return 0;
+}
+
+/**
+ * Double the file and its mapping => 0, or -1 (recording stops)
+ */
+static int replay_grow(ReplayLog *log)
+{
+    size_t cap = log->cap * 2;
+    if (ftruncate(log->fd, cap) == -1) {
+        perror("ftruncate replay log failed");
+        return -1;
+    }
+    char *p = mremap(log->base, log->cap, cap, MREMAP_MAYMOVE);
+    if (p == MAP_FAILED) {
+        perror("mremap replay log failed");
+        return -1;
+    }
+    log->base = p;
+    log->cap = cap;
+    return 0;
+}
+
+void replay_append(ReplayLog *log, int type, int player, int round, int tick,
+                   int a, int b, int c)
+{
+    if (!log->base)
+        return;
+    if (log->used + sizeof(ReplayRecord) > log->cap && replay_grow(log) != 0) {
+        replay_close(log);
+        return;
+    }
+
+    ReplayRecord *r = (ReplayRecord *)(log->base + log->used);
+    r->type = type;
+    r->player = player;
+    r->round = round;
+    r->tick = tick;
+    r->a = a;
+    r->b = b;
+    r->c = c;
+    r->time_ns = mono_ns() - log->t0_ns;
+    log->used += sizeof(ReplayRecord);
+}
+
+void replay_close(ReplayLog *log)
+{
+    if (!log->base)
+        return;
+    ReplayHeader *hdr = (ReplayHeader *)log->base;
+    hdr->records = (log->used - REPLAY_HEADER_SIZE) / sizeof(ReplayRecord);
+
+    munmap(log->base, log->cap);
+    if (ftruncate(log->fd, log->used) == -1)
+        perror("ftruncate replay log failed");
+    close(log->fd);
+    log->base = NULL;
+}
+
+const ReplayRecord *replay_load(const char *path, ReplayHeader *hdr, size_t *count)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        perror("open replay log failed");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < REPLAY_HEADER_SIZE) {
+        fprintf(stderr, "%s: not a replay log\n", path);
+        close(fd);
+        return NULL;
+    }
+    char *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("mmap replay log failed");
+        return NULL;
+    }
+
+    memcpy(hdr, p, sizeof(*hdr));
+    if (memcmp(hdr->magic, REPLAY_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != REPLAY_VERSION || hdr->header_size != REPLAY_HEADER_SIZE) {
+        fprintf(stderr, "%s: not a version %d replay log\n", path, REPLAY_VERSION);
+        munmap(p, st.st_size);
+        return NULL;
+    }
+    // The replay sizes its state from the config, same ranges as load_config()
+    const GameConfig *cfg = &hdr->cfg;
+    if (cfg->num_teams < 2 || cfg->num_teams > MAX_TEAMS ||
+        cfg->team_size < 1 || cfg->team_size > MAX_TEAM_SIZE ||
+        cfg->tick_hz < 1 || cfg->tick_hz > 1000) {
+        fprintf(stderr, "%s: bad game config in the header (%d teams x %d players, "
+                "tick_hz=%d)\n", path, cfg->num_teams, cfg->team_size, cfg->tick_hz);
+        munmap(p, st.st_size);
+        return NULL;
+    }
+
+    const ReplayRecord *recs = (const ReplayRecord *)(p + REPLAY_HEADER_SIZE);
+    size_t max = (st.st_size - REPLAY_HEADER_SIZE) / sizeof(ReplayRecord);
+    if (hdr->records > 0 && (size_t)hdr->records <= max) {
+        *count = hdr->records;
+    } else {
+        // The referee never closed the log: stop at the first unused record
+        size_t n = 0;
+        while (n < max && recs[n].type != 0)
+            n++;
+        *count = n;
+    }
+    return recs;
+}
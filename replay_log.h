@@ -0,0 +1,67 @@
+// replay_log.h
+#ifndef REPLAY_LOG_H
+#define REPLAY_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+#define REPLAY_MAGIC        "ROPELOG1"
+#define REPLAY_VERSION      4
+#define REPLAY_HEADER_SIZE  256   // records start at this offset
+
+// Record types and the meaning of a, b, c
+#define REC_GAME_START   1   // a = players
+#define REC_ROUND_START  2   // round
+#define REC_ENERGY       3   // player: a = raw energy, b = location (TickRecord)
+#define REC_EFFORT       4   // player: a = weighted effort, b = location (TickRecord, tick > 0)
+#define REC_SLOT         5   // player: a = effort sum, b = location, c = energy (shm slot)
+#define REC_LOCATION     6   // player: a = assigned location
+#define REC_TICK         7   // round, tick: a = elapsed s, b = round_check() => winner or -1
+#define REC_ROUND_END    8   // round: a = winner, b = match_check() => END_*, c = elapsed s
+#define REC_GAME_END     9   // a = match_winner()
+#define REC_CONFIG      10   // round: live key a (config.h) set to b from this round on
+
+typedef struct {
+    int16_t type;       // REC_*, 0 past the last record
+    int16_t player;     // referee index, -1 when not about one player
+    int32_t round;
+    int32_t tick;
+    int32_t a, b, c;
+    int64_t time_ns;    // CLOCK_MONOTONIC since the log was opened
+} ReplayRecord;
+
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t header_size;
+    int64_t records;    // set when the log is closed, 0 => scan for the end
+    GameConfig cfg;     // configuration of the recorded game
+    uint32_t seed;      // game seed, regenerates every random draw (rng.h)
+} ReplayHeader;
+
+// Writer state; appending is a copy into the mapping, the file grows by
+// doubling so remapping is rare
+typedef struct {
+    int fd;
+    char *base;         // NULL => not recording, appends are ignored
+    size_t cap;         // mapped bytes
+    size_t used;        // bytes of header + records
+    long long t0_ns;
+} ReplayLog;
+
+// Create path and write the header => 0, or -1 on error
+int replay_open(ReplayLog *log, const char *path, const GameConfig *cfg, uint32_t seed);
+
+void replay_append(ReplayLog *log, int type, int player, int round, int tick,
+                   int a, int b, int c);
+
+// Record the count, trim the file to its records and unmap it
+void replay_close(ReplayLog *log);
+
+// Map a log for reading => its records (*count of them), NULL on error or
+// if the header's config is out of the ranges load_config() accepts.
+// The header is copied into hdr.
+const ReplayRecord *replay_load(const char *path, ReplayHeader *hdr, size_t *count);
+
+#endif
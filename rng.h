@@ -0,0 +1,51 @@
+// rng.h
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Counter-based random numbers (Philox4x32-10): a block of 4 draws is a pure
+// function of a key and a counter, so any player's draws can be computed
+// anywhere, in any order and in bulk, and always come out the same.
+//
+// Key:     (game seed, stream) - one stream per player, plus the referee's
+// Counter: (a, b, domain, 0)   - e.g. (tick, round, RNG_TICK, 0)
+
+#define RNG_REFEREE  0xFFFFFFFFu   // stream of the referee's own draws
+
+// Domains, so the uses of one stream never share a counter
+#define RNG_TICK      0   // player: a = tick, b = round
+#define RNG_RESET     1   // player: a = round
+#define RNG_SPAWN     2   // referee: a = player index
+#define RNG_TIEBREAK  3   // referee: a = round
+
+// Philox constants
+#define PHILOX_M0  0xD2511F53u
+#define PHILOX_M1  0xCD9E8D57u
+#define PHILOX_W0  0x9E3779B9u
+#define PHILOX_W1  0xBB67AE85u
+
+typedef struct {
+    uint32_t k0;   // game seed
+    uint32_t k1;   // stream
+} RngKey;
+
+static inline RngKey rng_key(uint32_t seed, uint32_t stream)
+{
+    RngKey key = { seed, stream };
+    return key;
+}
+
+// The 4 draws of counter (a, b, domain, 0)
+void rng_block(RngKey key, uint32_t domain, uint32_t a, uint32_t b, uint32_t out[4]);
+
+// Map a draw to [lo, hi] by multiply-shift, no division
+static inline int rng_range(uint32_t x, int lo, int hi)
+{
+    return lo + (int)(((uint64_t)x * (uint32_t)(hi - lo + 1)) >> 32);
+}
+
+// Philox4x32-10 itself
+void philox4x32_10(const uint32_t ctr[4], RngKey key, uint32_t out[4]);
+
+#endif
@@ -0,0 +1,96 @@
+// shm.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm.h"
+
+#define SLOT_READ_RETRIES 64
+
+SharedState *shm_create(int num_slots, int *fd_out)
+{
+    size_t size = sizeof(SharedState) + (size_t)num_slots * sizeof(PlayerSlot);
+
+    // The players get it from the launch file actions (launch.h), nothing
+    // else inherits it
+    int fd = memfd_create("rope_shared", MFD_CLOEXEC);
+    if (fd == -1) {
+        perror("memfd_create failed");
+        return NULL;
+    }
+    if (ftruncate(fd, size) == -1) {
+        perror("ftruncate shared state failed");
+        close(fd);
+        return NULL;
+    }
+
+    SharedState *ss = shm_attach(fd);
+    if (!ss) {
+        close(fd);
+        return NULL;
+    }
+    memset(ss, 0, size);
+    ss->num_slots = num_slots;
+    *fd_out = fd;
+    return ss;
+}
+
+SharedState *shm_attach(int fd)
+{
+    // The region is sized by the referee for the configured teams
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("fstat shared state failed");
+        return NULL;
+    }
+    void *p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap shared state failed");
+        return NULL;
+    }
+    return (SharedState *)p;
+}
+
+void slot_publish(PlayerSlot *slot, const PlayerData *pd, int round, int tick,
+                  int weighted_effort, int effort_sum)
+{
+    unsigned int s = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    // Odd => readers retry until we are done
+    atomic_store_explicit(&slot->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->round = round;
+    slot->tick = tick;
+    slot->data = *pd;
+    slot->weighted_effort = weighted_effort;
+    slot->effort_sum = effort_sum;
+
+    atomic_store_explicit(&slot->seq, s + 2, memory_order_release);
+}
+
+int slot_read(PlayerSlot *slot, PlayerSlot *out)
+{
+    for (int i = 0; i < SLOT_READ_RETRIES; i++) {
+        unsigned int s1 = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (s1 & 1)
+            continue;
+
+        out->round = slot->round;
+        out->tick = slot->tick;
+        out->data = slot->data;
+        out->weighted_effort = slot->weighted_effort;
+        out->effort_sum = slot->effort_sum;
+
+        atomic_thread_fence(memory_order_acquire);
+        unsigned int s2 = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+        if (s1 == s2) {
+            atomic_store_explicit(&out->seq, s1, memory_order_relaxed);
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,55 @@
+// shm.h
+#ifndef SHM_H
+#define SHM_H
+
+#include <stdatomic.h>
+#include "constant.h"
+#include "player_logic.h"
+
+#define CACHE_LINE 64
+
+// One slot per player, written only by that player and read by the referee.
+// seq is odd while the player is writing and even once the slot is stable.
+typedef struct {
+    atomic_uint seq;
+    int round;            // round the data belongs to
+    int tick;             // ticks played so far in that round
+    PlayerData data;
+    int weighted_effort;  // effort of the last tick
+    int effort_sum;       // effort accumulated over the round
+} __attribute__((aligned(CACHE_LINE))) PlayerSlot;
+
+// Shared region created by the referee and inherited by the players.
+// Always present: it carries the round clock even in pipe mode.
+typedef struct {
+    atomic_int round;       // current round, set by the referee before SIG_PULL
+    atomic_llong epoch_ns;  // CLOCK_MONOTONIC start of the round, tick k of
+                            // every process is due at epoch_ns + k * tick_ns
+    long long tick_ns;      // tick period, 1e9 / tick_hz
+    int ipc_mode;           // IPC_PIPE or IPC_SHM (config.h)
+    unsigned int game_seed; // key of every random draw (rng.h)
+    int team_size;          // player id of team t is slot t * team_size + id
+    int num_slots;
+    PlayerParams params;    // ranges players draw from, taken at SIG_RESET_ENERGY;
+                            // the referee changes them only between rounds
+    atomic_int game;        // game being played; a player that sees a new one at
+                            // SIG_RESET_ENERGY starts over (rope_game --daemon)
+    PlayerSlot slots[] __attribute__((aligned(CACHE_LINE)));
+} SharedState;
+
+// Referee side: create the region with one slot per player, fd is passed
+// to the players
+SharedState *shm_create(int num_slots, int *fd_out);
+
+// Player side: map the region inherited through fd
+SharedState *shm_attach(int fd);
+
+// Publish a new version of the slot (single writer)
+void slot_publish(PlayerSlot *slot, const PlayerData *pd, int round, int tick,
+                  int weighted_effort, int effort_sum);
+
+// Copy a consistent snapshot of the slot => 0 on success, -1 if the writer
+// kept it busy for too long
+int slot_read(PlayerSlot *slot, PlayerSlot *out);
+
+#endif
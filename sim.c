@@ -0,0 +1,175 @@
+// sim.c
+#include <stdio.h>
+#include <stdlib.h>
+#include "constant.h"
+#include "game_rules.h"
+#include "ranking.h"
+#include "player_logic.h"
+#include "tick_kernel.h"
+#include "sim.h"
+
+#define MS_TO_NS(ms) ((long long)(ms) * 1000000LL)
+
+typedef struct {
+    int num_teams;
+    int team_size;
+    int n_players;
+    PlayerLanes lanes;                 // same order as the referee's players
+    Ranking *rank;                     // location ranking of each team
+    RngKey referee;                    // the referee's own draws
+    PlayerParams params;
+    long long now_ns;                  // the virtual clock
+} SimGame;
+
+/**
+ * Same ranking as the referee's assign_locations(): highest energy gets
+ * location 0, using the referee's view of the energy
+ */
+static void sim_assign_locations(SimGame *g)
+{
+    for (int team = 0; team < g->num_teams; team++) {
+        const int *energy = g->lanes.energy + team * g->team_size;
+        ranking_build(&g->rank[team], energy);
+
+        for (int i = 0; i < g->team_size; i++) {
+            g->lanes.location[team * g->team_size + i] = g->rank[team].pos[i];
+        }
+    }
+}
+
+/**
+ * dynamic_positions: re-rank from the energies after a tick, like the
+ * referee's send_moved_locations(). The moves count from the next tick on.
+ */
+static void sim_move_locations(SimGame *g)
+{
+    for (int team = 0; team < g->num_teams; team++) {
+        Ranking *r = &g->rank[team];
+        int *energy = g->lanes.energy + team * g->team_size;
+        int *location = g->lanes.location + team * g->team_size;
+        for (int i = 0; i < g->team_size; i++) {
+            ranking_update(r, i, energy[i]);
+        }
+
+        int moved = ranking_take_moved(r);
+        for (int k = 0; k < moved; k++) {
+            location[r->moved[k]] = r->pos[r->moved[k]];
+        }
+    }
+}
+
+/**
+ * Play one round => winning team
+ */
+static int sim_play_round(SimGame *g, const GameConfig *cfg, int round, long long start_ns,
+                          long long tick_ns, SimResult *res)
+{
+    lanes_reset_energy(&g->lanes, &g->params, round);
+    sim_assign_locations(g);
+    g->now_ns += MS_TO_NS(RESET_SETTLE_MS + READY_DELAY_MS);
+
+    long long epoch = g->now_ns;
+    int sums[MAX_TEAMS] = {0};
+    int winner = -1;
+
+    for (long long k = 1; winner < 0; k++) {
+        // Every player at once, vectorized where the CPU allows (tick_kernel.c)
+        tick_kernel(&g->lanes, &g->params, round, k, g->num_teams, g->team_size, sums);
+        res->ticks++;
+
+        // Every player reported => the tick closes right at its due time
+        g->now_ns = epoch + k * tick_ns;
+
+        int time_up;
+        long elapsed = (g->now_ns - start_ns) / 1000000000LL;
+        winner = round_check(cfg, sums, elapsed, &time_up);
+        if (cfg->dynamic_positions && winner < 0)
+            sim_move_locations(g);
+    }
+
+    g->now_ns += MS_TO_NS(STOP_SETTLE_MS);
+    return winner;
+}
+
+void sim_run_game(const GameConfig *cfg, unsigned int seed, SimResult *res)
+{
+    sim_play_game(cfg, seed, res, NULL, NULL);
+}
+
+void sim_play_game(const GameConfig *cfg, unsigned int seed, SimResult *res,
+                   SimRoundFn on_round, void *ctx)
+{
+    SimGame g;
+    g.num_teams = cfg->num_teams;
+    g.team_size = cfg->team_size;
+    g.n_players = g.num_teams * g.team_size;
+    g.rank = calloc(g.num_teams, sizeof(Ranking));
+    if (lanes_init(&g.lanes, g.n_players, seed) != 0 || !g.rank) {
+        perror("sim allocation failed");
+        exit(1);
+    }
+    for (int team = 0; team < g.num_teams; team++) {
+        if (ranking_init(&g.rank[team], g.team_size) != 0) {
+            perror("sim allocation failed");
+            exit(1);
+        }
+    }
+    g.params.energy_min = cfg->energy_min;
+    g.params.energy_max = cfg->energy_max;
+    g.params.decay_min = cfg->decay_min;
+    g.params.decay_max = cfg->decay_max;
+    g.params.recover_min = cfg->fall_recover_min;
+    g.params.recover_max = cfg->fall_recover_max;
+    g.referee = rng_key(seed, RNG_REFEREE);
+    g.now_ns = 0;
+
+    long long tick_ns = 1000000000LL / cfg->tick_hz;
+
+    // Spawn: the referee draws the initial energy and decay of each player,
+    // the same draws as spawn_players() with this game seed
+    for (int i = 0; i < g.n_players; i++) {
+        uint32_t draw[4];
+        rng_block(g.referee, RNG_SPAWN, i, 0, draw);
+        g.lanes.energy[i] = rng_range(draw[0], cfg->energy_min, cfg->energy_max);
+        g.lanes.decay_rate[i] = rng_range(draw[1], cfg->decay_min, cfg->decay_max);
+        g.lanes.is_fallen[i] = 0;
+        g.lanes.location[i] = 0;
+        g.lanes.fall_time_left[i] = 0;
+    }
+    g.now_ns += MS_TO_NS(SPAWN_SETTLE_MS);
+
+    long long start_ns = g.now_ns;
+    sim_assign_locations(&g);
+    g.now_ns += MS_TO_NS(LOCATION_SETTLE_MS);
+
+    MatchScore ms;
+    match_init(&ms, g.num_teams);
+    res->rounds = 0;
+    res->ticks = 0;
+
+    for (;;) {
+        res->rounds++;
+        int ticks_before = res->ticks;
+        int round_winner = sim_play_round(&g, cfg, res->rounds, start_ns, tick_ns, res);
+        if (on_round)
+            on_round(ctx, round_winner, res->ticks - ticks_before);
+
+        match_record(&ms, round_winner);
+        g.now_ns += MS_TO_NS(RESULT_PAUSE_MS);
+
+        long elapsed = (g.now_ns - start_ns) / 1000000000LL;
+        res->end_reason = match_check(&ms, cfg, round_winner, elapsed);
+        if (res->end_reason != END_NONE)
+            break;
+    }
+
+    for (int t = 0; t < g.num_teams; t++)
+        res->team_scores[t] = ms.team_scores[t];
+    res->winner = match_winner(&ms);
+    res->virtual_ns = g.now_ns + MS_TO_NS(FINAL_PAUSE_MS);
+
+    lanes_free(&g.lanes);
+    for (int team = 0; team < g.num_teams; team++)
+        ranking_free(&g.rank[team]);
+    free(g.rank);
+}
@@ -0,0 +1,31 @@
+// sim.h
+#ifndef SIM_H
+#define SIM_H
+
+#include "constant.h"
+#include "config.h"
+
+// Outcome of one simulated game
+typedef struct {
+    int team_scores[MAX_TEAMS];
+    int rounds;
+    int ticks;               // ticks played over all rounds
+    int winner;              // 1-based team, or 0 for a tie
+    int end_reason;          // END_* (game_rules.h)
+    long long virtual_ns;    // simulated game duration
+} SimResult;
+
+// Play a whole game on a virtual clock: the player state machine of
+// player_logic.c and the referee rules of game_rules.c, without processes,
+// signals or sleeps. The same seed always gives the same game, with the
+// same draws as a live `rope_game --seed` game (rng.h).
+void sim_run_game(const GameConfig *cfg, unsigned int seed, SimResult *res);
+
+// Called after every simulated round with its winner and length in ticks
+typedef void (*SimRoundFn)(void *ctx, int winner, int ticks);
+
+// sim_run_game() reporting each round to on_round (may be NULL)
+void sim_play_game(const GameConfig *cfg, unsigned int seed, SimResult *res,
+                   SimRoundFn on_round, void *ctx);
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * Rope Pulling Game - Live Stats
+ * Attaches to the stats page of a running referee (stats.h) and prints its
+ * counters every interval, like vmstat: the first line since the start of
+ * the game, the next ones per interval
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+
+#define HEADER_EVERY 20
+
+// Plain copy of the counters, players summed up
+typedef struct {
+    unsigned long long ticks, overruns, sig_tx, msg_rx, short_reads;
+    unsigned long long latency[STATS_LATENCY_BUCKETS];
+    unsigned long long gfx_sent, gfx_dropped, gfx_coalesced;
+    unsigned long long p_ticks, p_overruns, p_sig_rx, p_msg_tx, p_short_reads;
+} Snapshot;
+
+static void take_snapshot(StatsPage *sp, Snapshot *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->ticks = stat_get(&sp->referee.ticks);
+    s->overruns = stat_get(&sp->referee.tick_overruns);
+    s->sig_tx = stat_get(&sp->referee.signals_sent);
+    s->msg_rx = stat_get(&sp->referee.messages_received);
+    s->short_reads = stat_get(&sp->referee.short_reads);
+    for (int k = 0; k < STATS_LATENCY_BUCKETS; k++)
+        s->latency[k] = stat_get(&sp->reply_latency[k]);
+    s->gfx_sent = stat_get(&sp->graphics_sent);
+    s->gfx_dropped = stat_get(&sp->graphics_dropped);
+    s->gfx_coalesced = stat_get(&sp->graphics_coalesced);
+    for (int i = 0; i < sp->num_players; i++) {
+        StatCounters *c = &sp->players[i];
+        s->p_ticks += stat_get(&c->ticks);
+        s->p_overruns += stat_get(&c->tick_overruns);
+        s->p_sig_rx += stat_get(&c->signals_received);
+        s->p_msg_tx += stat_get(&c->messages_sent);
+        s->p_short_reads += stat_get(&c->short_reads);
+    }
+}
+
+/**
+ * Upper edge in us of the bucket holding fraction p of the replies, -1 if none
+ */
+static long long latency_percentile(const unsigned long long hist[], double p)
+{
+    unsigned long long total = 0;
+    for (int k = 0; k < STATS_LATENCY_BUCKETS; k++)
+        total += hist[k];
+    if (total == 0)
+        return -1;
+    unsigned long long want = (unsigned long long)(p * total + 0.5), seen = 0;
+    for (int k = 0; k < STATS_LATENCY_BUCKETS; k++) {
+        seen += hist[k];
+        if (seen >= want && hist[k] > 0)
+            return 1LL << k;
+    }
+    return 1LL << (STATS_LATENCY_BUCKETS - 1);
+}
+
+static void print_header(void)
+{
+    printf("%5s | %7s %4s %7s %7s %5s %7s %7s | %5s %5s %5s | %8s %4s %7s %7s %5s\n",
+           "round", "ticks", "ovr", "sig_tx", "msg_rx", "short", "rep_p50", "rep_p99",
+           "gfx", "drop", "coal", "p_ticks", "ovr", "sig_rx", "msg_tx", "short");
+}
+
+static void print_delta(StatsPage *sp, const Snapshot *now, const Snapshot *prev)
+{
+    unsigned long long hist[STATS_LATENCY_BUCKETS];
+    for (int k = 0; k < STATS_LATENCY_BUCKETS; k++)
+        hist[k] = now->latency[k] - prev->latency[k];
+    char p50[24] = "-", p99[24] = "-";
+    long long v = latency_percentile(hist, 0.50);
+    if (v >= 0)
+        snprintf(p50, sizeof(p50), "<%lldus", v);
+    v = latency_percentile(hist, 0.99);
+    if (v >= 0)
+        snprintf(p99, sizeof(p99), "<%lldus", v);
+
+    printf("%5d | %7llu %4llu %7llu %7llu %5llu %7s %7s | %5llu %5llu %5llu | %8llu %4llu %7llu %7llu %5llu\n",
+           atomic_load(&sp->round),
+           now->ticks - prev->ticks, now->overruns - prev->overruns,
+           now->sig_tx - prev->sig_tx, now->msg_rx - prev->msg_rx,
+           now->short_reads - prev->short_reads, p50, p99,
+           now->gfx_sent - prev->gfx_sent, now->gfx_dropped - prev->gfx_dropped,
+           now->gfx_coalesced - prev->gfx_coalesced,
+           now->p_ticks - prev->p_ticks, now->p_overruns - prev->p_overruns,
+           now->p_sig_rx - prev->p_sig_rx, now->p_msg_tx - prev->p_msg_tx,
+           now->p_short_reads - prev->p_short_reads);
+    fflush(stdout);
+}
+
+/**
+ * Pid of the most recently started game => pid, or -1 if none is running
+ */
+static pid_t newest_game(void)
+{
+    DIR *dir = opendir("/dev/shm");
+    if (!dir)
+        return -1;
+    pid_t best = -1;
+    time_t best_time = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        int pid;
+        if (sscanf(de->d_name, "rope_stats.%d", &pid) != 1)
+            continue;
+        char path[300];
+        struct stat st;
+        snprintf(path, sizeof(path), "/dev/shm/%s", de->d_name);
+        if (stat(path, &st) == 0 && kill(pid, 0) == 0 && st.st_mtime >= best_time) {
+            best = pid;
+            best_time = st.st_mtime;
+        }
+    }
+    closedir(dir);
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    double interval = 1.0;
+    long count = -1;             // < 0 => until the game is over
+    pid_t pid = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else if (argv[i][0] != '-' && pid == -1) {
+            pid = atoi(argv[i]);
+        } else {
+            interval = 0;
+            break;
+        }
+    }
+    if (interval <= 0) {
+        fprintf(stderr, "Usage: %s [-i seconds] [-n count] [referee_pid]\n"
+                "  without a pid, attach to the newest running game\n", argv[0]);
+        return 1;
+    }
+    if (pid == -1 && (pid = newest_game()) == -1) {
+        fprintf(stderr, "No running game found in /dev/shm\n");
+        return 1;
+    }
+
+    StatsPage *sp = stats_open(pid);
+    if (!sp)
+        return 1;
+    printf("Referee %d: %d teams x %d players\n", pid, sp->num_teams, sp->team_size);
+
+    Snapshot prev, now;
+    memset(&prev, 0, sizeof(prev));
+    for (long line = 0; count < 0 || line < count; line++) {
+        if (line % HEADER_EVERY == 0)
+            print_header();
+        take_snapshot(sp, &now);
+        print_delta(sp, &now, &prev);
+        prev = now;
+
+        if (atomic_load(&sp->finished)) {
+            printf("Game over\n");
+            break;
+        }
+        if (kill(pid, 0) == -1 && errno == ESRCH) {
+            printf("Referee %d is gone\n", pid);
+            break;
+        }
+        if (count < 0 || line + 1 < count)
+            usleep((useconds_t)(interval * 1e6));
+    }
+    return 0;
+}
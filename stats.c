@@ -0,0 +1,121 @@
+// stats.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "stats.h"
+
+static size_t stats_size(int num_players)
+{
+    return sizeof(StatsPage) + (size_t)num_players * sizeof(StatCounters);
+}
+
+int stats_latency_bucket(long long ns)
+{
+    long long us = ns / 1000;
+    int k = 0;
+    while (us > 0 && k < STATS_LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        k++;
+    }
+    return k;
+}
+
+/**
+ * Counters nobody else can see, used when the page can't be shared
+ */
+static StatsPage *stats_private(int num_players)
+{
+    StatsPage *sp = aligned_alloc(CACHE_LINE, stats_size(num_players));
+    if (!sp) {
+        perror("stats allocation failed");
+        exit(1);
+    }
+    memset(sp, 0, stats_size(num_players));
+    sp->num_players = num_players;
+    return sp;
+}
+
+StatsPage *stats_create(int num_teams, int team_size, int *fd_out)
+{
+    int num_players = num_teams * team_size;
+    size_t size = stats_size(num_players);
+    char name[64];
+    snprintf(name, sizeof(name), STATS_NAME_FMT, getpid());
+
+    *fd_out = -1;
+    shm_unlink(name);   // stale page of an earlier process with our pid
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        perror("shm_open stats failed, stats stay private");
+        return stats_private(num_players);
+    }
+    StatsPage *sp = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+        sp = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (sp == MAP_FAILED) {
+        perror("stats page setup failed, stats stay private");
+        close(fd);
+        shm_unlink(name);
+        return stats_private(num_players);
+    }
+
+    sp->version = STATS_VERSION;
+    sp->referee_pid = getpid();
+    sp->num_teams = num_teams;
+    sp->team_size = team_size;
+    sp->num_players = num_players;
+    // Magic last: rope_stat ignores a page that is still being set up
+    atomic_thread_fence(memory_order_release);
+    memcpy(sp->magic, STATS_MAGIC, sizeof(sp->magic));
+    *fd_out = fd;
+    return sp;
+}
+
+StatsPage *stats_attach(int fd, int num_players)
+{
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) == -1 || (size_t)st.st_size < stats_size(num_players))
+        return stats_private(num_players);
+    StatsPage *sp = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (sp == MAP_FAILED)
+        return stats_private(num_players);
+    return sp;
+}
+
+StatsPage *stats_open(pid_t pid)
+{
+    char name[64];
+    snprintf(name, sizeof(name), STATS_NAME_FMT, pid);
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        fprintf(stderr, "No stats page for pid %d\n", pid);
+        return NULL;
+    }
+    struct stat st;
+    StatsPage *sp = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(StatsPage))
+        sp = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (sp == MAP_FAILED || memcmp(sp->magic, STATS_MAGIC, sizeof(sp->magic)) != 0 ||
+        sp->version != STATS_VERSION || (size_t)st.st_size < stats_size(sp->num_players)) {
+        fprintf(stderr, "Stats page of pid %d is not a version %d page\n", pid, STATS_VERSION);
+        return NULL;
+    }
+    return sp;
+}
+
+void stats_finish(StatsPage *sp)
+{
+    atomic_store(&sp->finished, 1);
+    if (sp->referee_pid == getpid()) {
+        // rope_stat keeps its mapping, the name just goes away
+        char name[64];
+        snprintf(name, sizeof(name), STATS_NAME_FMT, sp->referee_pid);
+        shm_unlink(name);
+    }
+}
@@ -0,0 +1,81 @@
+// stats.h
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdatomic.h>
+#include <sys/types.h>
+#include "shm.h"
+
+#define STATS_MAGIC     "ROPESTAT"
+#define STATS_VERSION   1
+#define STATS_NAME_FMT  "/rope_stats.%d"   // shm_open name, referee pid
+
+// Reply latency histogram: bucket 0 counts replies under 1us, bucket k
+// replies within [2^(k-1), 2^k) us, the last bucket everything slower
+#define STATS_LATENCY_BUCKETS 24
+
+// Counters of one process or thread. Only relaxed atomic increments touch
+// them on the hot path, readers see a slightly stale but torn-free value.
+typedef struct {
+    atomic_ullong ticks;              // ticks processed (referee: closed)
+    atomic_ullong tick_overruns;      // ticks started after the next one was due
+    atomic_ullong signals_sent;       // SIG_* sent (thread engine: commands)
+    atomic_ullong signals_received;
+    atomic_ullong messages_sent;      // pipe or reply queue messages
+    atomic_ullong messages_received;
+    atomic_ullong short_reads;        // read_effort() returned part of a message
+} __attribute__((aligned(CACHE_LINE))) StatCounters;
+
+// Live stats page of one game, named after the referee pid so rope_stat can
+// attach to it. The players inherit its fd and write their own counters.
+typedef struct {
+    char magic[8];
+    int version;
+    int referee_pid;
+    int num_teams;
+    int team_size;
+    int num_players;
+    atomic_int round;                 // round in progress
+    atomic_int finished;              // the game is over
+    StatCounters referee;
+    atomic_ullong reply_latency[STATS_LATENCY_BUCKETS];  // energy request => reply
+    atomic_ullong graphics_sent;
+    atomic_ullong graphics_dropped;   // pipe feed full or busy
+    atomic_ullong graphics_coalesced; // shm feed overwritten before graphics read it
+    StatCounters players[];           // team t, player i => t * team_size + i
+} StatsPage;
+
+static inline void stat_inc(atomic_ullong *c)
+{
+    atomic_fetch_add_explicit(c, 1, memory_order_relaxed);
+}
+
+static inline void stat_add(atomic_ullong *c, unsigned long long n)
+{
+    atomic_fetch_add_explicit(c, n, memory_order_relaxed);
+}
+
+static inline unsigned long long stat_get(atomic_ullong *c)
+{
+    return atomic_load_explicit(c, memory_order_relaxed);
+}
+
+// Histogram bucket of a latency in nanoseconds
+int stats_latency_bucket(long long ns);
+
+// Referee side: create the page for the configured teams. If it can't be
+// shared the counters go to private memory and *fd_out is -1, so callers
+// never have to check.
+StatsPage *stats_create(int num_teams, int team_size, int *fd_out);
+
+// Player side: map the page inherited through fd, or a private page of
+// num_players counters if fd is -1 or can't be mapped
+StatsPage *stats_attach(int fd, int num_players);
+
+// rope_stat side: map the page of the game run by referee pid, read-only
+StatsPage *stats_open(pid_t pid);
+
+// Referee side: mark the game over and remove the name
+void stats_finish(StatsPage *sp);
+
+#endif
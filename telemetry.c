@@ -0,0 +1,327 @@
+// telemetry.c
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "loop.h"
+#include "telemetry.h"
+
+struct Sink {
+    const SinkFormat *format;
+    int fd;
+    int policy;
+
+    // Ring of depth updates, slot_size bytes each, len[] of them in use
+    char *ring;
+    size_t *len;
+    size_t slot_size;
+    int depth;
+    int head;                   // oldest pending
+    int count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t has_update;  // writer waits for an update
+    pthread_cond_t has_room;    // SINK_BLOCK referee waits for room
+    pthread_t thread;
+    int stopping;               // sink_close(): write what's queued and exit
+    long long stop_by_ns;       // ... but give up on the output past this
+    int gone;                   // output failed, nothing more is written
+
+    unsigned long long queued;
+    unsigned long long written;
+    unsigned long long dropped;
+
+    char *out;                  // writer thread: formatted bytes
+    size_t out_cap;
+};
+
+const char *sink_policy_name(int policy)
+{
+    switch (policy) {
+    case SINK_COALESCE: return "coalesce";
+    case SINK_DROP_OLDEST: return "drop_oldest";
+    case SINK_BLOCK: return "block";
+    }
+    return "?";
+}
+
+/* ---- Formats ---- */
+
+static size_t format_raw(const GraphicsMessage *msg, char *out, size_t cap)
+{
+    size_t size = GRAPHICS_MSG_SIZE(msg->numTeams, msg->teamSize);
+    if (size > cap)
+        return 0;
+    memcpy(out, msg, size);
+    return size;
+}
+
+static size_t format_json(const GraphicsMessage *msg, char *out, size_t cap)
+{
+    const int *values = (const int *)(msg + 1);
+    size_t n;
+    if (msg->roundNumber == -1) {
+        n = snprintf(out, cap, "{\"game_over\":true,\"winner\":%d,\"state_ns\":%lld,\"scores\":[",
+                     msg->roundWinner, msg->stateNs);
+    } else {
+        n = snprintf(out, cap, "{\"round\":%d,\"tick\":%d,\"winner\":%d,\"state_ns\":%lld,"
+                     "\"sums\":[", msg->roundNumber, msg->tick, msg->roundWinner, msg->stateNs);
+    }
+    for (int t = 0; t < msg->numTeams && n < cap; t++)
+        n += snprintf(out + n, cap - n, "%s%d", t ? "," : "", values[t]);
+    if (msg->roundNumber != -1 && n < cap) {
+        n += snprintf(out + n, cap - n, "],\"energies\":[");
+        values += msg->numTeams;
+        for (int k = 0; k < msg->numTeams * msg->teamSize && n < cap; k++)
+            n += snprintf(out + n, cap - n, "%s%d", k ? "," : "", values[k]);
+    }
+    if (n < cap)
+        n += snprintf(out + n, cap - n, "]}\n");
+    return n < cap ? n : 0;
+}
+
+static size_t header_telemetry(int num_teams, int team_size, char *out, size_t cap)
+{
+    TelemetryHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TELEMETRY_MAGIC, sizeof(hdr.magic));
+    hdr.version = TELEMETRY_VERSION;
+    hdr.num_teams = num_teams;
+    hdr.team_size = team_size;
+    hdr.header_size = sizeof(hdr);
+    if (sizeof(hdr) > cap)
+        return 0;
+    memcpy(out, &hdr, sizeof(hdr));
+    return sizeof(hdr);
+}
+
+const SinkFormat sink_format_graphics = { "graphics", NULL, format_raw };
+const SinkFormat sink_format_json = { "json", NULL, format_json };
+const SinkFormat sink_format_telemetry = { "telemetry", header_telemetry, format_raw };
+
+/* ---- Writer thread ---- */
+
+/**
+ * Write all of buf, waiting for a slow output until the sink is told to
+ * stop and its drain time is up => 0, or -1 if the output is gone
+ */
+static int write_all(Sink *s, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(s->fd, buf, len);
+        if (n > 0) {
+            buf += n;
+            len -= n;
+            continue;
+        }
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1 && errno != EAGAIN)
+            return -1;   // EPIPE: the reader went away
+
+        // Full: wait for room, a bit at a time so sink_close() is noticed
+        struct pollfd pfd = { .fd = s->fd, .events = POLLOUT };
+        poll(&pfd, 1, 100);
+        pthread_mutex_lock(&s->lock);
+        int give_up = s->stopping && mono_ns() > s->stop_by_ns;
+        pthread_mutex_unlock(&s->lock);
+        if (give_up)
+            return -1;
+    }
+    return 0;
+}
+
+static void *sink_main(void *arg)
+{
+    Sink *s = arg;
+    char *update = malloc(s->slot_size);
+    if (!update) {
+        perror("malloc sink update failed");
+        pthread_mutex_lock(&s->lock);
+        s->gone = 1;
+        pthread_cond_broadcast(&s->has_room);
+        pthread_mutex_unlock(&s->lock);
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        while (s->count == 0 && !s->stopping)
+            pthread_cond_wait(&s->has_update, &s->lock);
+        if (s->count == 0) {
+            pthread_mutex_unlock(&s->lock);
+            break;   // stopping and everything is written
+        }
+        // Take the oldest out, the referee can refill the slot meanwhile
+        size_t len = s->len[s->head];
+        memcpy(update, s->ring + (size_t)s->head * s->slot_size, len);
+        s->head = (s->head + 1) % s->depth;
+        s->count--;
+        pthread_cond_signal(&s->has_room);
+        pthread_mutex_unlock(&s->lock);
+
+        size_t n = s->format->format((GraphicsMessage *)update, s->out, s->out_cap);
+        if (n == 0) {
+            // Doesn't fit the output buffer, can't happen with its sizing
+            pthread_mutex_lock(&s->lock);
+            s->dropped++;
+            pthread_mutex_unlock(&s->lock);
+            continue;
+        }
+        if (write_all(s, s->out, n) != 0) {
+            pthread_mutex_lock(&s->lock);
+            s->gone = 1;
+            s->dropped += s->count + 1;
+            s->count = 0;
+            pthread_cond_broadcast(&s->has_room);
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        pthread_mutex_lock(&s->lock);
+        s->written++;
+        pthread_mutex_unlock(&s->lock);
+    }
+    free(update);
+    return NULL;
+}
+
+/* ---- Referee side ---- */
+
+static void sink_release(Sink *s)
+{
+    if (s->fd != -1)
+        close(s->fd);
+    free(s->ring);
+    free(s->len);
+    free(s->out);
+    free(s);
+}
+
+Sink *sink_open(const SinkFormat *format, int fd, int policy, int depth, int num_teams,
+                int team_size)
+{
+    Sink *s = calloc(1, sizeof(Sink));
+    if (!s) {
+        perror("calloc sink failed");
+        close(fd);
+        return NULL;
+    }
+    s->format = format;
+    s->fd = fd;
+    s->policy = policy;
+    s->depth = depth;
+    s->slot_size = GRAPHICS_MSG_SIZE(num_teams, team_size);
+    // Worst case of the JSON line: every int at its longest
+    s->out_cap = 256 + 12 * (size_t)num_teams * (team_size + 1);
+    if (s->out_cap < s->slot_size)
+        s->out_cap = s->slot_size;
+    s->ring = malloc((size_t)depth * s->slot_size);
+    s->len = calloc(depth, sizeof(size_t));
+    s->out = malloc(s->out_cap);
+    if (!s->ring || !s->len || !s->out) {
+        perror("malloc sink queue failed");
+        sink_release(s);
+        return NULL;
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->has_update, NULL);
+    pthread_cond_init(&s->has_room, NULL);
+
+    // The writer thread waits for room itself, with poll()
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    if (format->header) {
+        size_t n = format->header(num_teams, team_size, s->out, s->out_cap);
+        if (n > 0 && write_all(s, s->out, n) != 0) {
+            perror("writing the sink header failed");
+            sink_free(s);
+            return NULL;
+        }
+    }
+
+    if (pthread_create(&s->thread, NULL, sink_main, s) != 0) {
+        perror("pthread_create sink failed");
+        sink_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+int sink_push(Sink *s, const GraphicsMessage *msg)
+{
+    size_t len = GRAPHICS_MSG_SIZE(msg->numTeams, msg->teamSize);
+    if (len > s->slot_size)
+        len = s->slot_size;   // can't happen, the sink is sized for the game
+    int displaced = 0;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->gone) {
+        s->dropped++;
+        pthread_mutex_unlock(&s->lock);
+        return -1;
+    }
+    int slot;
+    if (s->policy == SINK_COALESCE && s->count == s->depth) {
+        // Full: the latest state matters most, the newest pending one is replaced
+        slot = (s->head + s->count - 1) % s->depth;
+        displaced = 1;
+    } else {
+        if (s->count == s->depth && s->policy == SINK_BLOCK) {
+            while (s->count == s->depth && !s->gone)
+                pthread_cond_wait(&s->has_room, &s->lock);
+        }
+        if (s->gone) {
+            s->dropped++;
+            pthread_mutex_unlock(&s->lock);
+            return -1;
+        }
+        if (s->count == s->depth) {
+            s->head = (s->head + 1) % s->depth;   // SINK_DROP_OLDEST
+            s->count--;
+            displaced = 1;
+        }
+        slot = (s->head + s->count) % s->depth;
+        s->count++;
+    }
+    memcpy(s->ring + (size_t)slot * s->slot_size, msg, len);
+    s->len[slot] = len;
+    s->queued++;
+    s->dropped += displaced;
+    pthread_cond_signal(&s->has_update);
+    pthread_mutex_unlock(&s->lock);
+    return displaced;
+}
+
+void sink_print(Sink *s)
+{
+    pthread_mutex_lock(&s->lock);
+    printf("Sink %s (%s, queue %d): queued=%llu written=%llu dropped=%llu%s\n",
+           s->format->name, sink_policy_name(s->policy), s->depth, s->queued, s->written,
+           s->dropped, s->gone ? ", output gone" : "");
+    pthread_mutex_unlock(&s->lock);
+}
+
+void sink_close(Sink *s, int drain_ms)
+{
+    pthread_mutex_lock(&s->lock);
+    s->stopping = 1;
+    s->stop_by_ns = mono_ns() + drain_ms * 1000000LL;
+    pthread_cond_signal(&s->has_update);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+    close(s->fd);
+    s->fd = -1;
+}
+
+void sink_free(Sink *s)
+{
+    if (!s)
+        return;
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->has_update);
+    pthread_cond_destroy(&s->has_room);
+    sink_release(s);
+}
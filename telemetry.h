@@ -0,0 +1,64 @@
+// telemetry.h
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "constant.h"
+#include "config.h"
+
+// Telemetry fan-out: every state update of the referee (a GraphicsMessage)
+// goes to a set of sinks, the graphics pipe, a JSON-lines stream and a binary
+// telemetry file. Each sink has a bounded queue and a writer thread of its
+// own; the referee only ever enqueues, and what happens when a queue is full
+// is the sink's policy. A slow or hung consumer costs its own sink updates,
+// never the tick loop its time.
+
+// Binary telemetry file: this header, then the updates as sent to graphics,
+// each GRAPHICS_MSG_SIZE(numTeams, teamSize) bytes
+#define TELEMETRY_MAGIC    "ROPETLM1"
+#define TELEMETRY_VERSION  1
+
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t num_teams;
+    int32_t team_size;
+    int32_t header_size;    // updates start at this offset
+} TelemetryHeader;
+
+// How a sink turns updates into bytes. header may be NULL. Both write at
+// most cap bytes into out => how many.
+typedef struct {
+    const char *name;
+    size_t (*header)(int num_teams, int team_size, char *out, size_t cap);
+    size_t (*format)(const GraphicsMessage *msg, char *out, size_t cap);
+} SinkFormat;
+
+extern const SinkFormat sink_format_graphics;   // raw GraphicsMessages
+extern const SinkFormat sink_format_json;       // one JSON object per line
+extern const SinkFormat sink_format_telemetry;  // TelemetryHeader + raw messages
+
+typedef struct Sink Sink;
+
+// Start a sink writing to fd (it owns fd from now on) with policy SINK_*
+// (config.h) and up to depth pending updates of num_teams x team_size
+// => the sink, or NULL
+Sink *sink_open(const SinkFormat *format, int fd, int policy, int depth, int num_teams,
+                int team_size);
+
+// Queue a copy of msg => 0, 1 if an older pending update had to make room
+// (counted as dropped), or -1 if the output is gone
+int sink_push(Sink *s, const GraphicsMessage *msg);
+
+// "name: written=.. dropped=.. policy=.."
+void sink_print(Sink *s);
+
+// Write what is still queued, waiting at most drain_ms for a slow output,
+// then stop the thread and close the fd. The counters stay for sink_print().
+void sink_close(Sink *s, int drain_ms);
+void sink_free(Sink *s);
+
+const char *sink_policy_name(int policy);
+
+#endif
@@ -0,0 +1,464 @@
+// text.c
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glut.h>
+#include <GL/glext.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "renderer.h"
+#include "text.h"
+
+#define ATLAS_W      512
+#define ATLAS_H      256
+#define GLYPH_FIRST  32     // ' '
+#define GLYPH_LAST   126    // '~', anything else shows as '?'
+#define GLYPH_PAD    2      // room for glyphs reaching left of the pen
+
+// Floats per vertex: anchor xy, offset xy (pixels), uv, rgb, follow rope, bob phase
+#define VERTEX_FLOATS  11
+#define GLYPH_FLOATS   (4 * VERTEX_FLOATS)
+
+// Atlas cell of each font, big enough for any of its glyphs
+typedef struct {
+    void *glut_font;
+    int cell_w, cell_h;
+    int descent;             // pixels of the cell below the baseline
+    int cols;
+    int top;                 // first atlas row of the font
+    int advance[GLYPH_LAST + 1];
+    unsigned char ink[GLYPH_LAST + 1][4];   // x0, y0, x1, y1 of the set pixels in the cell
+} FontCells;
+
+static FontCells fonts[2] = {
+    { GLUT_BITMAP_HELVETICA_12, 16, 20, 5, 0, 0, {0}, {{0}} },
+    { GLUT_BITMAP_HELVETICA_18, 24, 28, 7, 0, 0, {0}, {{0}} },
+};
+
+static int atlas_ready = 0;
+static GLuint atlas_tex, text_program, quad_ebo;
+static GLint frame_uniform, viewport_uniform;
+static int ebo_glyphs = 0;     // quads the index buffer covers
+
+static const char *text_vs =
+    "#version 330\n"
+    "layout(location = 0) in vec2 a_anchor;\n"
+    "layout(location = 1) in vec2 a_offset;\n"
+    "layout(location = 2) in vec2 a_uv;\n"
+    "layout(location = 3) in vec3 a_color;\n"
+    "layout(location = 4) in vec2 a_follow;\n"   // follows the rope, bob phase
+    "uniform vec3 u_frame;\n"                    // rope offset, bob frame, bobbing
+    "uniform vec2 u_viewport;\n"
+    "out vec2 v_uv;\n"
+    "out vec3 v_color;\n"
+    "void main() {\n"
+    "    vec2 a = a_anchor;\n"
+    "    a.x += a_follow.x * u_frame.x;\n"
+    "    if (a_follow.y >= 0.0)\n"
+    "        a.y += u_frame.z * 0.005 * sin(u_frame.y + a_follow.y);\n"
+    // Whole pixels, like glRasterPos
+    "    vec2 px = floor((a * 0.5 + 0.5) * u_viewport + 0.5) + a_offset;\n"
+    "    gl_Position = vec4(px / u_viewport * 2.0 - 1.0, 0.0, 1.0);\n"
+    "    v_uv = a_uv;\n"
+    "    v_color = a_color;\n"
+    "}\n";
+
+static const char *text_fs =
+    "#version 330\n"
+    "uniform sampler2D u_atlas;\n"
+    "in vec2 v_uv;\n"
+    "in vec3 v_color;\n"
+    "out vec4 frag;\n"
+    "void main() {\n"
+    // Bitmap glyphs: a pixel is set or not, no blending needed
+    "    if (texture(u_atlas, v_uv).r < 0.5)\n"
+    "        discard;\n"
+    "    frag = vec4(v_color, 1.0);\n"
+    "}\n";
+
+static int glyph_of(unsigned char c)
+{
+    return (c >= GLYPH_FIRST && c <= GLYPH_LAST) ? c : '?';
+}
+
+/**
+ * Box of each glyph's set pixels, so its quad covers nothing else: most of
+ * a cell is empty, and under software GL every covered pixel costs
+ */
+static int find_ink(void)
+{
+    unsigned char *px = malloc(ATLAS_W * ATLAS_H);
+    if (!px)
+        return -1;
+    glBindTexture(GL_TEXTURE_2D, atlas_tex);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_UNSIGNED_BYTE, px);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    for (int f = 0; f < 2; f++) {
+        FontCells *fc = &fonts[f];
+        for (int c = GLYPH_FIRST; c <= GLYPH_LAST; c++) {
+            int k = c - GLYPH_FIRST;
+            int cx = (k % fc->cols) * fc->cell_w, cy = fc->top + (k / fc->cols) * fc->cell_h;
+            int x0 = fc->cell_w, y0 = fc->cell_h, x1 = -1, y1 = -1;
+            for (int y = 0; y < fc->cell_h; y++) {
+                for (int x = 0; x < fc->cell_w; x++) {
+                    if (px[(cy + y) * ATLAS_W + cx + x] < 128)
+                        continue;
+                    if (x < x0) x0 = x;
+                    if (x > x1) x1 = x;
+                    if (y < y0) y0 = y;
+                    if (y > y1) y1 = y;
+                }
+            }
+            unsigned char *ink = fc->ink[c];
+            if (x1 < 0) {
+                ink[0] = ink[1] = ink[2] = ink[3] = 0;   // blank, like ' '
+            } else {
+                ink[0] = x0;
+                ink[1] = y0;
+                ink[2] = x1 + 1;
+                ink[3] = y1 + 1;
+            }
+        }
+    }
+    free(px);
+    return 0;
+}
+
+/**
+ * Draw every glyph of both fonts once, white on black, into the atlas
+ */
+static int rasterize_atlas(void)
+{
+    GLint viewport[4];
+    GLfloat clear[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear);
+
+    glGenTextures(1, &atlas_tex);
+    glBindTexture(GL_TEXTURE_2D, atlas_tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_W, ATLAS_H, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas_tex, 0);
+    int ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (ok) {
+        glViewport(0, 0, ATLAS_W, ATLAS_H);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glColor3f(1.0f, 1.0f, 1.0f);
+
+        int top = 0;
+        for (int f = 0; f < 2; f++) {
+            FontCells *fc = &fonts[f];
+            fc->cols = ATLAS_W / fc->cell_w;
+            fc->top = top;
+            for (int c = GLYPH_FIRST; c <= GLYPH_LAST; c++) {
+                int k = c - GLYPH_FIRST;
+                fc->advance[c] = glutBitmapWidth(fc->glut_font, c);
+                // The raster color is latched here, so white glyphs
+                glWindowPos2i((k % fc->cols) * fc->cell_w + GLYPH_PAD,
+                              top + (k / fc->cols) * fc->cell_h + fc->descent);
+                glutBitmapCharacter(fc->glut_font, c);
+            }
+            top += ((GLYPH_LAST - GLYPH_FIRST) / fc->cols + 1) * fc->cell_h;
+        }
+        ok = top <= ATLAS_H;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    if (ok)
+        ok = find_ink() == 0;
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clear[0], clear[1], clear[2], clear[3]);
+    return ok && glGetError() == GL_NO_ERROR ? 0 : -1;
+}
+
+int text_init(void)
+{
+    text_program = renderer_program(text_vs, text_fs);
+    if (!text_program || rasterize_atlas() != 0) {
+        fprintf(stderr, "No glyph atlas, text stays glutBitmapCharacter\n");
+        return -1;
+    }
+    frame_uniform = glGetUniformLocation(text_program, "u_frame");
+    viewport_uniform = glGetUniformLocation(text_program, "u_viewport");
+    glUseProgram(text_program);
+    glUniform1i(glGetUniformLocation(text_program, "u_atlas"), 0);
+    glUseProgram(0);
+    glGenBuffers(1, &quad_ebo);
+    atlas_ready = 1;
+    return 0;
+}
+
+void text_batch_init(TextBatch *b)
+{
+    memset(b, 0, sizeof(*b));
+    b->dirty_lo = 1;
+}
+
+void text_clear(TextBatch *b)
+{
+    b->n_labels = 0;
+    b->n_glyphs = 0;
+    b->dirty_lo = 1;
+    b->dirty_hi = 0;
+}
+
+int text_label(TextBatch *b, int font, int capacity)
+{
+    if (capacity > TEXT_MAX_LEN - 1)
+        capacity = TEXT_MAX_LEN - 1;
+    if (b->n_labels == b->max_labels) {
+        b->max_labels = b->max_labels ? b->max_labels * 2 : 16;
+        b->labels = realloc(b->labels, b->max_labels * sizeof(TextLabel));
+        if (!b->labels) {
+            perror("realloc failed");
+            exit(1);
+        }
+    }
+    if (b->n_glyphs + capacity > b->max_glyphs) {
+        while (b->n_glyphs + capacity > b->max_glyphs)
+            b->max_glyphs = b->max_glyphs ? b->max_glyphs * 2 : 256;
+        b->verts = realloc(b->verts, (size_t)b->max_glyphs * GLYPH_FLOATS * sizeof(float));
+        if (!b->verts) {
+            perror("realloc failed");
+            exit(1);
+        }
+    }
+
+    int id = b->n_labels++;
+    TextLabel *l = &b->labels[id];
+    memset(l, 0, sizeof(*l));
+    l->font = font;
+    l->first = b->n_glyphs;
+    l->capacity = capacity;
+    l->bob_phase = TEXT_NO_BOB;
+    b->n_glyphs += capacity;
+    // Empty slots are zero-sized quads
+    memset(b->verts + (size_t)l->first * GLYPH_FLOATS, 0,
+           (size_t)capacity * GLYPH_FLOATS * sizeof(float));
+    if (b->dirty_lo > b->dirty_hi) {
+        b->dirty_lo = l->first;
+        b->dirty_hi = b->n_glyphs - 1;
+    } else {
+        if (l->first < b->dirty_lo)
+            b->dirty_lo = l->first;
+        if (b->n_glyphs - 1 > b->dirty_hi)
+            b->dirty_hi = b->n_glyphs - 1;
+    }
+    return id;
+}
+
+/**
+ * Write the glyph quads of label id into the batch and mark them for upload
+ */
+static void layout_label(TextBatch *b, int id)
+{
+    if (!atlas_ready)
+        return;
+    TextLabel *l = &b->labels[id];
+    FontCells *fc = &fonts[l->font];
+    float follow = l->follow_rope ? 1.0f : 0.0f;
+    int pen = 0;
+
+    for (int k = 0; k < l->capacity; k++) {
+        float *v = b->verts + (size_t)(l->first + k) * GLYPH_FLOATS;
+        if (l->str[k] == '\0') {
+            // Past the end: collapse the rest of the slots
+            memset(v, 0, (size_t)(l->capacity - k) * GLYPH_FLOATS * sizeof(float));
+            break;
+        }
+        int c = glyph_of(l->str[k]);
+        int cell = c - GLYPH_FIRST;
+        const unsigned char *ink = fc->ink[c];
+        int cx = (cell % fc->cols) * fc->cell_w, cy = fc->top + (cell / fc->cols) * fc->cell_h;
+        float u0 = (float)(cx + ink[0]) / ATLAS_W, u1 = (float)(cx + ink[2]) / ATLAS_W;
+        float v0 = (float)(cy + ink[1]) / ATLAS_H, v1 = (float)(cy + ink[3]) / ATLAS_H;
+        float x0 = pen - GLYPH_PAD + ink[0], x1 = pen - GLYPH_PAD + ink[2];
+        float y0 = ink[1] - fc->descent, y1 = ink[3] - fc->descent;
+        const float corners[4][4] = {
+            { x0, y0, u0, v0 }, { x1, y0, u1, v0 }, { x1, y1, u1, v1 }, { x0, y1, u0, v1 }
+        };
+        for (int q = 0; q < 4; q++, v += VERTEX_FLOATS) {
+            v[0] = l->x;
+            v[1] = l->y;
+            v[2] = corners[q][0];
+            v[3] = corners[q][1];
+            v[4] = corners[q][2];
+            v[5] = corners[q][3];
+            v[6] = l->color[0];
+            v[7] = l->color[1];
+            v[8] = l->color[2];
+            v[9] = follow;
+            v[10] = l->bob_phase;
+        }
+        pen += fc->advance[c];
+    }
+
+    int last = l->first + l->capacity - 1;
+    if (b->dirty_lo > b->dirty_hi) {
+        b->dirty_lo = l->first;
+        b->dirty_hi = last;
+    } else {
+        if (l->first < b->dirty_lo)
+            b->dirty_lo = l->first;
+        if (last > b->dirty_hi)
+            b->dirty_hi = last;
+    }
+}
+
+void text_set(TextBatch *b, int id, const char *str)
+{
+    TextLabel *l = &b->labels[id];
+    l->has_value = 0;
+    if (strncmp(l->str, str, l->capacity) == 0)
+        return;
+    snprintf(l->str, l->capacity + 1, "%s", str);
+    layout_label(b, id);
+}
+
+void text_set_int(TextBatch *b, int id, const char *fmt, int value)
+{
+    TextLabel *l = &b->labels[id];
+    if (l->has_value && l->value == value)
+        return;
+    char buf[TEXT_MAX_LEN];
+    snprintf(buf, sizeof(buf), fmt, value);
+    text_set(b, id, buf);
+    l->has_value = 1;
+    l->value = value;
+}
+
+void text_place(TextBatch *b, int id, float x, float y, const float color[3],
+                int follow_rope, float bob_phase)
+{
+    TextLabel *l = &b->labels[id];
+    if (l->x == x && l->y == y && memcmp(l->color, color, sizeof(l->color)) == 0 &&
+        l->follow_rope == follow_rope && l->bob_phase == bob_phase)
+        return;
+    l->x = x;
+    l->y = y;
+    memcpy(l->color, color, sizeof(l->color));
+    l->follow_rope = follow_rope;
+    l->bob_phase = bob_phase;
+    layout_label(b, id);
+}
+
+/**
+ * Indices of n quads, two triangles each, shared by every batch
+ */
+static void grow_quad_indices(int n)
+{
+    if (n <= ebo_glyphs)
+        return;
+    int cap = ebo_glyphs ? ebo_glyphs : 256;
+    while (cap < n)
+        cap *= 2;
+    GLuint *idx = malloc((size_t)cap * 6 * sizeof(GLuint));
+    if (!idx) {
+        perror("malloc failed");
+        exit(1);
+    }
+    for (int q = 0; q < cap; q++) {
+        static const int tri[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int k = 0; k < 6; k++)
+            idx[q * 6 + k] = q * 4 + tri[k];
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cap * 6 * sizeof(GLuint), idx,
+                 GL_STATIC_DRAW);
+    free(idx);
+    ebo_glyphs = cap;
+}
+
+/**
+ * Send the changed glyph slots to the GL buffer
+ */
+static void upload(TextBatch *b)
+{
+    if (!b->vao) {
+        glGenVertexArrays(1, &b->vao);
+        glGenBuffers(1, &b->vbo);
+        glBindVertexArray(b->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+        static const int sizes[5] = { 2, 2, 2, 3, 2 };
+        int offset = 0;
+        for (int k = 0; k < 5; k++) {
+            glEnableVertexAttribArray(k);
+            glVertexAttribPointer(k, sizes[k], GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float),
+                                  (void *)(offset * sizeof(float)));
+            offset += sizes[k];
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_ebo);
+    } else {
+        glBindVertexArray(b->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    }
+
+    size_t glyph_bytes = GLYPH_FLOATS * sizeof(float);
+    if (b->max_glyphs > b->gpu_glyphs) {
+        glBufferData(GL_ARRAY_BUFFER, b->max_glyphs * glyph_bytes, b->verts, GL_DYNAMIC_DRAW);
+        b->gpu_glyphs = b->max_glyphs;
+    } else if (b->dirty_lo <= b->dirty_hi) {
+        glBufferSubData(GL_ARRAY_BUFFER, b->dirty_lo * glyph_bytes,
+                        (b->dirty_hi - b->dirty_lo + 1) * glyph_bytes,
+                        b->verts + (size_t)b->dirty_lo * GLYPH_FLOATS);
+    }
+    b->dirty_lo = 1;
+    b->dirty_hi = 0;
+}
+
+/**
+ * No atlas: the labels one character at a time, as graphics.c used to
+ */
+static void draw_bitmap_labels(TextBatch *b, float rope_offset, float bob_frame, int bobbing)
+{
+    for (int id = 0; id < b->n_labels; id++) {
+        TextLabel *l = &b->labels[id];
+        if (l->str[0] == '\0')
+            continue;
+        float x = l->x + (l->follow_rope ? rope_offset : 0.0f);
+        float y = l->y;
+        if (bobbing && l->bob_phase >= 0.0f)
+            y += 0.005f * sinf(bob_frame + l->bob_phase);
+        glColor3fv(l->color);
+        glRasterPos2f(x, y);
+        for (int i = 0; l->str[i] != '\0'; i++) {
+            glutBitmapCharacter(fonts[l->font].glut_font, l->str[i]);
+        }
+    }
+}
+
+void text_draw(TextBatch *b, float rope_offset, float bob_frame, int bobbing)
+{
+    if (b->n_glyphs == 0)
+        return;
+    if (!atlas_ready) {
+        draw_bitmap_labels(b, rope_offset, bob_frame, bobbing);
+        return;
+    }
+
+    grow_quad_indices(b->n_glyphs);
+    upload(b);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glUseProgram(text_program);
+    glUniform3f(frame_uniform, rope_offset, bob_frame, bobbing ? 1.0f : 0.0f);
+    glUniform2f(viewport_uniform, viewport[2], viewport[3]);
+    glBindTexture(GL_TEXTURE_2D, atlas_tex);
+    glDrawElements(GL_TRIANGLES, b->n_glyphs * 6, GL_UNSIGNED_INT, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
@@ -0,0 +1,66 @@
+// text.h
+#ifndef TEXT_H
+#define TEXT_H
+
+// Text of graphics.c. The GLUT bitmap fonts are rasterized once into a
+// glyph atlas texture, and every label of a batch is drawn by one textured
+// draw. A label is laid out into the batch's vertex buffer only when its
+// text, place or color changes; the rope offset and the bobbing are applied
+// by the shader, so labels that just move along are not uploaded again.
+// Without the atlas (no OpenGL 3.3) the same labels are drawn with
+// glutBitmapCharacter.
+
+#define TEXT_SMALL  0   // GLUT_BITMAP_HELVETICA_12
+#define TEXT_LARGE  1   // GLUT_BITMAP_HELVETICA_18
+
+#define TEXT_MAX_LEN  96
+
+// Label does not bob (text_place())
+#define TEXT_NO_BOB  -1.0f
+
+typedef struct {
+    char str[TEXT_MAX_LEN];    // shown text
+    int value;                 // last text_set_int() value
+    int has_value;
+    int font;                  // TEXT_SMALL or TEXT_LARGE
+    int first;                 // first glyph slot in the batch
+    int capacity;              // glyph slots, longer text is cut
+    float x, y;                // raster position, clip space
+    float color[3];
+    int follow_rope;           // moves with the rope offset
+    float bob_phase;           // bobs like the player with this phase
+} TextLabel;
+
+typedef struct {
+    TextLabel *labels;
+    int n_labels;
+    int max_labels;
+    int n_glyphs;              // glyph slots handed out
+    int max_glyphs;
+    float *verts;              // laid-out glyph slots
+    int dirty_lo, dirty_hi;    // glyph slots to upload, lo > hi => none
+    unsigned int vao, vbo;
+    int gpu_glyphs;            // glyph slots the GL buffer holds
+} TextBatch;
+
+// Rasterize the atlas, after renderer_init() succeeded => 0, or -1 if it
+// can't be done (text_draw() then uses glutBitmapCharacter)
+int text_init(void);
+
+// Empty batch; text_clear() drops every label of one
+void text_batch_init(TextBatch *b);
+void text_clear(TextBatch *b);
+
+// New label of up to capacity characters, empty and unplaced => its id
+int text_label(TextBatch *b, int font, int capacity);
+
+// Change a label. Each is a no-op when nothing changes.
+void text_set(TextBatch *b, int id, const char *str);
+void text_set_int(TextBatch *b, int id, const char *fmt, int value);  // fmt has one %d
+void text_place(TextBatch *b, int id, float x, float y, const float color[3],
+                int follow_rope, float bob_phase);
+
+// Draw every label of the batch at once
+void text_draw(TextBatch *b, float rope_offset, float bob_frame, int bobbing);
+
+#endif
@@ -0,0 +1,371 @@
+// tick_kernel.c
+#include <stdlib.h>
+#include <string.h>
+#include "tick_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNEL_X86 1
+#endif
+
+#define LANE_ALIGN 64
+
+typedef struct {
+    // Players [0, n) play the tick, n is a multiple of width
+    void (*ticks)(PlayerLanes *pl, const PlayerParams *pp, int round, int tick, int n);
+    int width;
+    int (*sum)(const int *v, int n);
+} KernelImpl;
+
+static int kernel_isa = -1;   // -1 => pick at the first tick
+
+int lanes_init(PlayerLanes *pl, int n, uint32_t game_seed)
+{
+    // aligned_alloc() wants a multiple of the alignment
+    size_t size = ((n * sizeof(int) + LANE_ALIGN - 1) / LANE_ALIGN) * LANE_ALIGN;
+    int **arrays[] = { &pl->energy, &pl->location, &pl->decay_rate, &pl->is_fallen,
+                       &pl->fall_time_left, &pl->effort };
+
+    memset(pl, 0, sizeof(*pl));
+    pl->n = n;
+    pl->game_seed = game_seed;
+    for (size_t k = 0; k < sizeof(arrays) / sizeof(arrays[0]); k++) {
+        *arrays[k] = aligned_alloc(LANE_ALIGN, size > 0 ? size : LANE_ALIGN);
+        if (!*arrays[k]) {
+            lanes_free(pl);
+            return -1;
+        }
+        memset(*arrays[k], 0, size);
+    }
+    return 0;
+}
+
+void lanes_free(PlayerLanes *pl)
+{
+    free(pl->energy);
+    free(pl->location);
+    free(pl->decay_rate);
+    free(pl->is_fallen);
+    free(pl->fall_time_left);
+    free(pl->effort);
+    memset(pl, 0, sizeof(*pl));
+}
+
+void lanes_get(const PlayerLanes *pl, int i, PlayerData *pd)
+{
+    pd->energy = pl->energy[i];
+    pd->location = pl->location[i];
+    pd->decay_rate = pl->decay_rate[i];
+    pd->is_fallen = pl->is_fallen[i];
+    pd->fall_time_left = pl->fall_time_left[i];
+}
+
+void lanes_put(PlayerLanes *pl, int i, const PlayerData *pd)
+{
+    pl->energy[i] = pd->energy;
+    pl->location[i] = pd->location;
+    pl->decay_rate[i] = pd->decay_rate;
+    pl->is_fallen[i] = pd->is_fallen;
+    pl->fall_time_left[i] = pd->fall_time_left;
+}
+
+void lanes_reset_energy(PlayerLanes *pl, const PlayerParams *pp, int round)
+{
+    for (int i = 0; i < pl->n; i++) {
+        PlayerData pd;
+        lanes_get(pl, i, &pd);
+        player_reset_energy(&pd, pp, rng_key(pl->game_seed, i), round);
+        lanes_put(pl, i, &pd);
+    }
+}
+
+/**
+ * The reference: player_tick() on one player
+ */
+static void tick_one(PlayerLanes *pl, const PlayerParams *pp, int round, int tick, int i)
+{
+    PlayerData pd;
+    int event;
+    lanes_get(pl, i, &pd);
+    pl->effort[i] = player_tick(&pd, pp, rng_key(pl->game_seed, i), round, tick, &event);
+    lanes_put(pl, i, &pd);
+}
+
+static void ticks_scalar(PlayerLanes *pl, const PlayerParams *pp, int round, int tick, int n)
+{
+    for (int i = 0; i < n; i++)
+        tick_one(pl, pp, round, tick, i);
+}
+
+static int sum_scalar(const int *v, int n)
+{
+    int s = 0;
+    for (int i = 0; i < n; i++)
+        s += v[i];
+    return s;
+}
+
+#ifdef KERNEL_X86
+
+/* ---- AVX2: 8 players per step ---- */
+
+/**
+ * High 32 bits of the unsigned 32x32 products, lane by lane
+ */
+__attribute__((target("avx2")))
+static inline __m256i mulhi_avx2(__m256i a, __m256i b)
+{
+    __m256i even = _mm256_mul_epu32(a, b);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+/**
+ * rng_range() of every lane, span = hi - lo + 1
+ */
+__attribute__((target("avx2")))
+static inline __m256i range_avx2(__m256i x, int lo, int span)
+{
+    return _mm256_add_epi32(_mm256_set1_epi32(lo), mulhi_avx2(x, _mm256_set1_epi32(span)));
+}
+
+/**
+ * Philox4x32-10 of 8 counters at once (rng.c), c is replaced by the draws
+ */
+__attribute__((target("avx2")))
+static inline void philox_avx2(__m256i c[4], __m256i k0, __m256i k1)
+{
+    const __m256i m0 = _mm256_set1_epi32(PHILOX_M0), m1 = _mm256_set1_epi32(PHILOX_M1);
+    for (int r = 0; r < 10; r++) {
+        __m256i hi0 = mulhi_avx2(m0, c[0]), lo0 = _mm256_mullo_epi32(m0, c[0]);
+        __m256i hi1 = mulhi_avx2(m1, c[2]), lo1 = _mm256_mullo_epi32(m1, c[2]);
+        c[0] = _mm256_xor_si256(_mm256_xor_si256(hi1, c[1]), k0);
+        c[1] = lo1;
+        c[2] = _mm256_xor_si256(_mm256_xor_si256(hi0, c[3]), k1);
+        c[3] = lo0;
+        k0 = _mm256_add_epi32(k0, _mm256_set1_epi32(PHILOX_W0));
+        k1 = _mm256_add_epi32(k1, _mm256_set1_epi32(PHILOX_W1));
+    }
+}
+
+__attribute__((target("avx2")))
+static void ticks_avx2(PlayerLanes *pl, const PlayerParams *pp, int round, int tick, int n)
+{
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i k0 = _mm256_set1_epi32(pl->game_seed);
+    const int decay_span = pp->decay_max - pp->decay_min + 1;
+    const int recover_span = pp->recover_max - pp->recover_min + 1;
+
+    for (int i = 0; i < n; i += 8) {
+        __m256i e = _mm256_load_si256((__m256i *)&pl->energy[i]);
+        __m256i loc = _mm256_load_si256((__m256i *)&pl->location[i]);
+        __m256i f = _mm256_load_si256((__m256i *)&pl->is_fallen[i]);
+        __m256i t = _mm256_load_si256((__m256i *)&pl->fall_time_left[i]);
+
+        // The tick's random block of each player: key (seed, i), counter (tick, round)
+        __m256i d[4] = { _mm256_set1_epi32(tick), _mm256_set1_epi32(round),
+                         _mm256_set1_epi32(RNG_TICK), zero };
+        philox_avx2(d, k0, _mm256_add_epi32(_mm256_set1_epi32(i),
+                                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+
+        __m256i standing = _mm256_cmpeq_epi32(f, zero);
+        __m256i fallen = _mm256_xor_si256(standing, ones);
+
+        // Fallen: count down, recover with a fresh energy once it runs out
+        t = _mm256_blendv_epi8(t, _mm256_sub_epi32(t, one), fallen);
+        __m256i recover = _mm256_and_si256(fallen, _mm256_cmpgt_epi32(one, t));
+        __m256i e_rec = _mm256_min_epi32(range_avx2(d[DRAW_ENERGY], 50, 50),
+                                         _mm256_set1_epi32(pp->energy_max));
+        e = _mm256_blendv_epi8(e, e_rec, recover);
+        f = _mm256_andnot_si256(recover, f);
+
+        // Standing: decay, then fall when out of energy or with a 10% chance
+        __m256i decay = range_avx2(d[DRAW_ENERGY], pp->decay_min, decay_span);
+        e = _mm256_blendv_epi8(e, _mm256_sub_epi32(e, decay), standing);
+        __m256i empty = _mm256_cmpgt_epi32(one, e);
+        __m256i unlucky = _mm256_cmpgt_epi32(_mm256_set1_epi32(10), range_avx2(d[DRAW_FALL], 0, 100));
+        __m256i fall = _mm256_and_si256(standing, _mm256_or_si256(empty, unlucky));
+        e = _mm256_blendv_epi8(e, _mm256_max_epi32(e, zero), fall);
+        f = _mm256_blendv_epi8(f, one, fall);
+        t = _mm256_blendv_epi8(t, range_avx2(d[DRAW_RECOVER], pp->recover_min, recover_span), fall);
+
+        // Weighted effort, 0 while on the ground
+        __m256i effort = _mm256_mullo_epi32(e, _mm256_add_epi32(loc, one));
+        effort = _mm256_and_si256(effort, _mm256_cmpeq_epi32(f, zero));
+
+        _mm256_store_si256((__m256i *)&pl->energy[i], e);
+        _mm256_store_si256((__m256i *)&pl->is_fallen[i], f);
+        _mm256_store_si256((__m256i *)&pl->fall_time_left[i], t);
+        _mm256_store_si256((__m256i *)&pl->effort[i], effort);
+    }
+}
+
+__attribute__((target("avx2")))
+static int sum_avx2(const int *v, int n)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_add_epi32(acc, _mm256_loadu_si256((const __m256i *)&v[i]));
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s) + sum_scalar(v + i, n - i);
+}
+
+/* ---- SSE4.1: 4 players per step, same steps as AVX2 ---- */
+
+__attribute__((target("sse4.1")))
+static inline __m128i mulhi_sse41(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_blend_epi16(_mm_srli_epi64(even, 32), odd, 0xCC);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i range_sse41(__m128i x, int lo, int span)
+{
+    return _mm_add_epi32(_mm_set1_epi32(lo), mulhi_sse41(x, _mm_set1_epi32(span)));
+}
+
+__attribute__((target("sse4.1")))
+static inline void philox_sse41(__m128i c[4], __m128i k0, __m128i k1)
+{
+    const __m128i m0 = _mm_set1_epi32(PHILOX_M0), m1 = _mm_set1_epi32(PHILOX_M1);
+    for (int r = 0; r < 10; r++) {
+        __m128i hi0 = mulhi_sse41(m0, c[0]), lo0 = _mm_mullo_epi32(m0, c[0]);
+        __m128i hi1 = mulhi_sse41(m1, c[2]), lo1 = _mm_mullo_epi32(m1, c[2]);
+        c[0] = _mm_xor_si128(_mm_xor_si128(hi1, c[1]), k0);
+        c[1] = lo1;
+        c[2] = _mm_xor_si128(_mm_xor_si128(hi0, c[3]), k1);
+        c[3] = lo0;
+        k0 = _mm_add_epi32(k0, _mm_set1_epi32(PHILOX_W0));
+        k1 = _mm_add_epi32(k1, _mm_set1_epi32(PHILOX_W1));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void ticks_sse41(PlayerLanes *pl, const PlayerParams *pp, int round, int tick, int n)
+{
+    const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi32(1);
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i k0 = _mm_set1_epi32(pl->game_seed);
+    const int decay_span = pp->decay_max - pp->decay_min + 1;
+    const int recover_span = pp->recover_max - pp->recover_min + 1;
+
+    for (int i = 0; i < n; i += 4) {
+        __m128i e = _mm_load_si128((__m128i *)&pl->energy[i]);
+        __m128i loc = _mm_load_si128((__m128i *)&pl->location[i]);
+        __m128i f = _mm_load_si128((__m128i *)&pl->is_fallen[i]);
+        __m128i t = _mm_load_si128((__m128i *)&pl->fall_time_left[i]);
+
+        __m128i d[4] = { _mm_set1_epi32(tick), _mm_set1_epi32(round),
+                         _mm_set1_epi32(RNG_TICK), zero };
+        philox_sse41(d, k0, _mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3)));
+
+        __m128i standing = _mm_cmpeq_epi32(f, zero);
+        __m128i fallen = _mm_xor_si128(standing, ones);
+
+        t = _mm_blendv_epi8(t, _mm_sub_epi32(t, one), fallen);
+        __m128i recover = _mm_and_si128(fallen, _mm_cmpgt_epi32(one, t));
+        __m128i e_rec = _mm_min_epi32(range_sse41(d[DRAW_ENERGY], 50, 50),
+                                      _mm_set1_epi32(pp->energy_max));
+        e = _mm_blendv_epi8(e, e_rec, recover);
+        f = _mm_andnot_si128(recover, f);
+
+        __m128i decay = range_sse41(d[DRAW_ENERGY], pp->decay_min, decay_span);
+        e = _mm_blendv_epi8(e, _mm_sub_epi32(e, decay), standing);
+        __m128i empty = _mm_cmpgt_epi32(one, e);
+        __m128i unlucky = _mm_cmpgt_epi32(_mm_set1_epi32(10), range_sse41(d[DRAW_FALL], 0, 100));
+        __m128i fall = _mm_and_si128(standing, _mm_or_si128(empty, unlucky));
+        e = _mm_blendv_epi8(e, _mm_max_epi32(e, zero), fall);
+        f = _mm_blendv_epi8(f, one, fall);
+        t = _mm_blendv_epi8(t, range_sse41(d[DRAW_RECOVER], pp->recover_min, recover_span), fall);
+
+        __m128i effort = _mm_mullo_epi32(e, _mm_add_epi32(loc, one));
+        effort = _mm_and_si128(effort, _mm_cmpeq_epi32(f, zero));
+
+        _mm_store_si128((__m128i *)&pl->energy[i], e);
+        _mm_store_si128((__m128i *)&pl->is_fallen[i], f);
+        _mm_store_si128((__m128i *)&pl->fall_time_left[i], t);
+        _mm_store_si128((__m128i *)&pl->effort[i], effort);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static int sum_sse41(const int *v, int n)
+{
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_epi32(acc, _mm_loadu_si128((const __m128i *)&v[i]));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc) + sum_scalar(v + i, n - i);
+}
+
+#endif
+
+static const KernelImpl impls[] = {
+    [KERNEL_SCALAR] = { ticks_scalar, 1, sum_scalar },
+#ifdef KERNEL_X86
+    [KERNEL_SSE41]  = { ticks_sse41, 4, sum_sse41 },
+    [KERNEL_AVX2]   = { ticks_avx2, 8, sum_avx2 },
+#endif
+};
+
+static int isa_supported(int isa)
+{
+    if (isa == KERNEL_SCALAR)
+        return 1;
+#ifdef KERNEL_X86
+    __builtin_cpu_init();
+    if (isa == KERNEL_SSE41)
+        return __builtin_cpu_supports("sse4.1");
+    if (isa == KERNEL_AVX2)
+        return __builtin_cpu_supports("avx2");
+#endif
+    return 0;
+}
+
+int tick_kernel_use(int isa)
+{
+    if (isa < KERNEL_SCALAR || isa > KERNEL_AVX2 || !isa_supported(isa))
+        return -1;
+    kernel_isa = isa;
+    return 0;
+}
+
+int tick_kernel_isa(void)
+{
+    if (kernel_isa < 0) {
+        int isa = KERNEL_AVX2;
+        while (!isa_supported(isa))
+            isa--;
+        kernel_isa = isa;
+    }
+    return kernel_isa;
+}
+
+const char *tick_kernel_name(int isa)
+{
+    static const char *names[] = { "scalar", "sse4.1", "avx2" };
+    return isa >= KERNEL_SCALAR && isa <= KERNEL_AVX2 ? names[isa] : "?";
+}
+
+void tick_kernel(PlayerLanes *pl, const PlayerParams *pp, int round, int tick,
+                 int num_teams, int team_size, int sums[])
+{
+    const KernelImpl *k = &impls[tick_kernel_isa()];
+
+    // Whole vectors, then the last few players one by one
+    int vec = pl->n - pl->n % k->width;
+    k->ticks(pl, pp, round, tick, vec);
+    for (int i = vec; i < pl->n; i++)
+        tick_one(pl, pp, round, tick, i);
+
+    for (int t = 0; t < num_teams; t++)
+        sums[t] += k->sum(&pl->effort[t * team_size], team_size);
+}
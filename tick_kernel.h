@@ -0,0 +1,53 @@
+// tick_kernel.h
+#ifndef TICK_KERNEL_H
+#define TICK_KERNEL_H
+
+#include "constant.h"
+#include "player_logic.h"
+#include "rng.h"
+
+// Players as struct-of-arrays, the layout the tick kernel works on.
+// Player i is member i % team_size of team i / team_size.
+typedef struct {
+    int n;
+    int *energy;
+    int *location;
+    int *decay_rate;
+    int *is_fallen;
+    int *fall_time_left;
+    int *effort;             // weighted effort of the last tick
+    uint32_t game_seed;      // player i draws with rng_key(game_seed, i)
+} PlayerLanes;
+
+// Kernel implementations, the best one the CPU supports is picked at the
+// first tick
+#define KERNEL_SCALAR  0
+#define KERNEL_SSE41   1
+#define KERNEL_AVX2    2
+
+// Allocate zeroed arrays for n players => 0, or -1 if out of memory
+int lanes_init(PlayerLanes *pl, int n, uint32_t game_seed);
+void lanes_free(PlayerLanes *pl);
+
+// Copy player i out of / into the lanes
+void lanes_get(const PlayerLanes *pl, int i, PlayerData *pd);
+void lanes_put(PlayerLanes *pl, int i, const PlayerData *pd);
+
+// player_reset_energy() for every player, before round
+void lanes_reset_energy(PlayerLanes *pl, const PlayerParams *pp, int round);
+
+// Play tick `tick` of round `round` for every player and add each team's
+// efforts to sums[t]. The vector paths compute each player's random block
+// (rng.h) in its lane, so the results are bit-identical to calling
+// player_tick() player by player.
+void tick_kernel(PlayerLanes *pl, const PlayerParams *pp, int round, int tick,
+                 int num_teams, int team_size, int sums[]);
+
+// Force an implementation => 0, or -1 if this CPU can't run it (benchmarks)
+int tick_kernel_use(int isa);
+
+// Implementation in use, and the name of one
+int tick_kernel_isa(void);
+const char *tick_kernel_name(int isa);
+
+#endif
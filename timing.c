@@ -0,0 +1,68 @@
+// timing.c
+#include <stdio.h>
+#include <math.h>
+#include "timing.h"
+
+void timing_add(TimingStats *ts, long long ns)
+{
+    if (ts->count == 0 || ns < ts->min)
+        ts->min = ns;
+    if (ts->count == 0 || ns > ts->max)
+        ts->max = ns;
+    ts->count++;
+    ts->sum += ns;
+    ts->sum_sq += (double)ns * ns;
+
+    int b = 0;
+    for (long long us = ns / 1000; us > 0 && b < TIMING_BUCKETS - 1; us >>= 1)
+        b++;
+    ts->hist[b]++;
+}
+
+void timing_print(const char *label, const TimingStats *ts)
+{
+    if (ts->count == 0) {
+        printf("%s: no samples\n", label);
+        return;
+    }
+    double mean = ts->sum / ts->count;
+    double var = ts->sum_sq / ts->count - mean * mean;
+    double jitter = var > 0 ? sqrt(var) : 0;   // standard deviation
+
+    printf("%s: n=%lld mean=%.1fus jitter=%.1fus min=%.1fus max=%.1fus\n",
+           label, ts->count, mean / 1000.0, jitter / 1000.0,
+           ts->min / 1000.0, ts->max / 1000.0);
+}
+
+void timing_print_hist(const char *label, const TimingStats *ts)
+{
+    int first = 0, last = TIMING_BUCKETS - 1;
+    while (first < TIMING_BUCKETS && ts->hist[first] == 0)
+        first++;
+    while (last > first && ts->hist[last] == 0)
+        last--;
+    if (first == TIMING_BUCKETS)
+        return;
+
+    long long most = 0;
+    for (int b = first; b <= last; b++) {
+        if (ts->hist[b] > most)
+            most = ts->hist[b];
+    }
+    printf("%s histogram:\n", label);
+    for (int b = first; b <= last; b++) {
+        char range[32];
+        if (b == 0)
+            snprintf(range, sizeof(range), "<1us");
+        else if (b == TIMING_BUCKETS - 1)
+            snprintf(range, sizeof(range), ">=%lldms", (1LL << (b - 1)) / 1000);
+        else if ((1LL << b) <= 1000)
+            snprintf(range, sizeof(range), "%lld-%lldus", 1LL << (b - 1), 1LL << b);
+        else
+            snprintf(range, sizeof(range), "%.1f-%.1fms", (1LL << (b - 1)) / 1000.0,
+                     (1LL << b) / 1000.0);
+        int bar = (int)((ts->hist[b] * 40 + most - 1) / most);
+        printf("  %14s %8lld %.*s\n", range, ts->hist[b], bar,
+               "########################################");
+    }
+}
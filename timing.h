@@ -0,0 +1,28 @@
+// timing.h
+#ifndef TIMING_H
+#define TIMING_H
+
+// Histogram buckets: [0] below 1us, [k] from 2^(k-1) to 2^k us, the last
+// one open-ended (over 262ms)
+#define TIMING_BUCKETS 20
+
+// Running statistics of a latency in nanoseconds
+typedef struct {
+    long long count;
+    long long min;
+    long long max;
+    double sum;
+    double sum_sq;
+    long long hist[TIMING_BUCKETS];
+} TimingStats;
+
+void timing_add(TimingStats *ts, long long ns);
+
+// Print "label: n=.. mean=..us jitter=..us min=..us max=..us"
+void timing_print(const char *label, const TimingStats *ts);
+
+// Print the histogram, one "1-2us  count ####" line per bucket between the
+// first and the last used one
+void timing_print_hist(const char *label, const TimingStats *ts);
+
+#endif
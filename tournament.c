@@ -0,0 +1,332 @@
+/**
+ * Rope Pulling Game - Tournament Runner
+ * Plays many independent virtual-clock games (sim.c) across all cores and
+ * reports win rates, round counts and round-length distributions
+ *
+ * Game g is played with seed + g, so a tournament gives the same results as
+ * `rope_game --headless --virtual-clock --games N --seed S`, whatever the
+ * number of threads. Workers own a range of game indexes and take chunks
+ * from its front; a worker that runs dry steals half of another worker's
+ * remaining range. Ranges are packed in one atomic word, so neither taking
+ * nor stealing needs a lock. Each worker keeps its statistics locally and
+ * adds them to the totals with atomic adds once it is done.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "constant.h"
+#include "config.h"
+#include "game_rules.h"
+#include "loop.h"
+#include "sim.h"
+
+#define CHUNK_GAMES        64    // games a worker takes from its range at once
+#define LINEAR_BUCKETS     64    // round lengths 0..63 ticks, one bucket each
+#define LOG_BUCKETS        26    // then [64 * 2^k, 64 * 2^(k+1)) ticks
+#define ROUND_BUCKETS      (LINEAR_BUCKETS + LOG_BUCKETS)
+#define GAME_ROUND_BUCKETS 32    // rounds per game, the last one is "or more"
+
+// Statistics of a set of games. Only unsigned long long fields, so two sets
+// can be added field by field (merge_stats).
+typedef struct {
+    unsigned long long games;
+    unsigned long long wins[MAX_TEAMS + 1];        // ties, then one per team
+    unsigned long long round_wins[MAX_TEAMS];
+    unsigned long long end_reasons[END_TIME_LIMIT + 1];
+    unsigned long long rounds;
+    unsigned long long ticks;
+    unsigned long long virtual_ms;
+    unsigned long long round_ticks[ROUND_BUCKETS];   // round length histogram
+    unsigned long long game_rounds[GAME_ROUND_BUCKETS];
+} TourStats;
+
+// Game indexes [next, end) still to play, packed as next << 32 | end
+typedef struct {
+    atomic_ullong range;
+} __attribute__((aligned(64))) WorkRange;
+
+typedef struct {
+    pthread_t thread;
+    int index;
+    unsigned long long played;   // games played by this worker
+    unsigned long long steals;   // successful steals
+    TourStats stats;             // local until the worker is done
+} __attribute__((aligned(64))) Worker;
+
+static GameConfig cfg;
+static unsigned int base_seed;
+static int n_workers;
+static WorkRange *ranges;
+static Worker *workers;
+static TourStats totals;         // filled by merge_stats() only
+
+static unsigned long long pack_range(unsigned int next, unsigned int end)
+{
+    return ((unsigned long long)next << 32) | end;
+}
+
+/**
+ * Take up to CHUNK_GAMES from the front of our own range => 0 when empty
+ */
+static int take_chunk(WorkRange *r, unsigned int *begin, unsigned int *end)
+{
+    unsigned long long cur = atomic_load_explicit(&r->range, memory_order_acquire);
+    for (;;) {
+        unsigned int next = cur >> 32, last = (unsigned int)cur;
+        if (next >= last)
+            return 0;
+        unsigned int take = last - next < CHUNK_GAMES ? last - next : CHUNK_GAMES;
+        if (atomic_compare_exchange_weak_explicit(&r->range, &cur, pack_range(next + take, last),
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            *begin = next;
+            *end = next + take;
+            return 1;
+        }
+    }
+}
+
+/**
+ * Move the back half of victim's range into our (empty) range => 0 if the
+ * victim had nothing left
+ */
+static int steal_half(WorkRange *victim, WorkRange *mine)
+{
+    unsigned long long cur = atomic_load_explicit(&victim->range, memory_order_acquire);
+    for (;;) {
+        unsigned int next = cur >> 32, last = (unsigned int)cur;
+        if (next >= last)
+            return 0;
+        unsigned int half = (last - next + 1) / 2;
+        if (atomic_compare_exchange_weak_explicit(&victim->range, &cur, pack_range(next, last - half),
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            atomic_store_explicit(&mine->range, pack_range(last - half, last), memory_order_release);
+            return 1;
+        }
+    }
+}
+
+static int round_bucket(int ticks)
+{
+    if (ticks < LINEAR_BUCKETS)
+        return ticks;
+    int k = 0;
+    while (k < LOG_BUCKETS - 1 && ticks >= (LINEAR_BUCKETS << (k + 1)))
+        k++;
+    return LINEAR_BUCKETS + k;
+}
+
+static long bucket_low(int b)
+{
+    return b < LINEAR_BUCKETS ? b : (long)LINEAR_BUCKETS << (b - LINEAR_BUCKETS);
+}
+
+/**
+ * sim_play_game() hook: one simulated round is over
+ */
+static void on_round(void *ctx, int winner, int ticks)
+{
+    TourStats *st = ctx;
+    st->round_wins[winner]++;
+    st->round_ticks[round_bucket(ticks)]++;
+}
+
+static void play_game(Worker *w, unsigned int g)
+{
+    SimResult res;
+    sim_play_game(&cfg, base_seed + g, &res, on_round, &w->stats);
+
+    TourStats *st = &w->stats;
+    st->games++;
+    st->wins[res.winner]++;
+    st->end_reasons[res.end_reason]++;
+    st->rounds += res.rounds;
+    st->ticks += res.ticks;
+    st->virtual_ms += res.virtual_ns / 1000000LL;
+    st->game_rounds[res.rounds < GAME_ROUND_BUCKETS ? res.rounds : GAME_ROUND_BUCKETS - 1]++;
+    w->played++;
+}
+
+/**
+ * Add src into dst with relaxed atomic adds, safe against other mergers
+ */
+static void merge_stats(TourStats *dst, const TourStats *src)
+{
+    unsigned long long *d = (unsigned long long *)dst;
+    const unsigned long long *s = (const unsigned long long *)src;
+    for (size_t i = 0; i < sizeof(TourStats) / sizeof(unsigned long long); i++) {
+        if (s[i])
+            __atomic_fetch_add(&d[i], s[i], __ATOMIC_RELAXED);
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    Worker *w = arg;
+    WorkRange *mine = &ranges[w->index];
+
+    for (;;) {
+        unsigned int begin, end;
+        while (take_chunk(mine, &begin, &end)) {
+            for (unsigned int g = begin; g < end; g++)
+                play_game(w, g);
+        }
+
+        // Own range is empty: steal from the others, nearest first
+        int stolen = 0;
+        for (int k = 1; k < n_workers && !stolen; k++) {
+            stolen = steal_half(&ranges[(w->index + k) % n_workers], mine);
+        }
+        if (!stolen)
+            break;   // nothing left anywhere
+        w->steals++;
+    }
+
+    merge_stats(&totals, &w->stats);
+    return NULL;
+}
+
+/**
+ * Percentile of the round length histogram, in ticks (lower bucket bound)
+ */
+static long round_percentile(const TourStats *st, double p)
+{
+    unsigned long long total = 0, seen = 0;
+    for (int b = 0; b < ROUND_BUCKETS; b++)
+        total += st->round_ticks[b];
+    if (total == 0)
+        return 0;
+    unsigned long long target = (unsigned long long)ceil(p * total);
+    for (int b = 0; b < ROUND_BUCKETS; b++) {
+        seen += st->round_ticks[b];
+        if (seen >= target && st->round_ticks[b] > 0)
+            return bucket_low(b);
+    }
+    return bucket_low(ROUND_BUCKETS - 1);
+}
+
+static void print_bar(unsigned long long count, unsigned long long total)
+{
+    int width = total ? (int)(40.0 * count / total + 0.5) : 0;
+    for (int i = 0; i < width; i++)
+        putchar('#');
+    putchar('\n');
+}
+
+static void print_report(const TourStats *st, double wall)
+{
+    double n = st->games;
+
+    printf("\n==== Tournament (games=%llu, seed=%u, threads=%d) ====\n",
+           st->games, base_seed, n_workers);
+    for (int t = 0; t < cfg.num_teams; t++) {
+        double p = st->wins[t + 1] / n;
+        printf("Team%d wins=%llu (%.2f%% +/- %.2f%%), rounds won=%llu\n", t + 1,
+               st->wins[t + 1], 100.0 * p, 196.0 * sqrt(p * (1.0 - p) / n), st->round_wins[t]);
+    }
+    printf("Ties=%llu (%.2f%%)\n", st->wins[0], 100.0 * st->wins[0] / n);
+    printf("Ended by max_score=%llu, consecutive_wins=%llu, max_game_time=%llu\n",
+           st->end_reasons[END_MAX_SCORE], st->end_reasons[END_CONSECUTIVE],
+           st->end_reasons[END_TIME_LIMIT]);
+    printf("Avg rounds=%.3f avg ticks/round=%.2f avg virtual time=%.1fs\n",
+           st->rounds / n, st->rounds ? (double)st->ticks / st->rounds : 0.0,
+           st->virtual_ms / 1000.0 / n);
+
+    printf("\nRound length (ticks at tick_hz=%d): p50=%ld p90=%ld p99=%ld\n", cfg.tick_hz,
+           round_percentile(st, 0.50), round_percentile(st, 0.90), round_percentile(st, 0.99));
+    for (int b = 0; b < ROUND_BUCKETS; b++) {
+        if (st->round_ticks[b] == 0)
+            continue;
+        if (b < LINEAR_BUCKETS)
+            printf("%10ld       ", bucket_low(b));
+        else
+            printf("%10ld-%-6ld", bucket_low(b), bucket_low(b + 1) - 1);
+        printf("%10llu ", st->round_ticks[b]);
+        print_bar(st->round_ticks[b], st->rounds);
+    }
+
+    printf("\nRounds per game:\n");
+    for (int b = 0; b < GAME_ROUND_BUCKETS; b++) {
+        if (st->game_rounds[b] == 0)
+            continue;
+        printf("%10d%s %10llu ", b, b == GAME_ROUND_BUCKETS - 1 ? "+" : " ", st->game_rounds[b]);
+        print_bar(st->game_rounds[b], st->games);
+    }
+
+    printf("\nWall time=%.3fs (%.0f games/s, %.0f games/s per thread)\n",
+           wall, wall > 0 ? n / wall : 0.0, wall > 0 ? n / wall / n_workers : 0.0);
+    for (int i = 0; i < n_workers; i++) {
+        printf("  worker %2d: games=%llu steals=%llu\n", i, workers[i].played, workers[i].steals);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long games = 100000;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int seed = time(NULL);
+    const char *config_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && !config_path) {
+            config_path = argv[i];
+        } else {
+            config_path = NULL;
+            break;
+        }
+    }
+    if (!config_path || games < 1 || games > 0xFFFFFFFFL || threads < 1) {
+        fprintf(stderr, "Usage: %s [--games N] [--threads T] [--seed S] <config_file>\n", argv[0]);
+        return 1;
+    }
+    if (load_config(config_path, &cfg) != 0) {
+        return 1;
+    }
+    base_seed = seed;
+    n_workers = threads < games ? threads : (int)games;
+
+    ranges = aligned_alloc(64, n_workers * sizeof(WorkRange));
+    workers = aligned_alloc(64, n_workers * sizeof(Worker));
+    if (!ranges || !workers) {
+        perror("aligned_alloc failed");
+        return 1;
+    }
+    memset(workers, 0, n_workers * sizeof(Worker));
+
+    // Even split up front, stealing evens out the rest
+    for (int i = 0; i < n_workers; i++) {
+        unsigned int begin = games * i / n_workers;
+        unsigned int end = games * (i + 1) / n_workers;
+        atomic_init(&ranges[i].range, pack_range(begin, end));
+    }
+
+    long long start = mono_ns();
+    for (int i = 0; i < n_workers; i++) {
+        workers[i].index = i;
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            perror("pthread_create worker failed");
+            return 1;
+        }
+    }
+    for (int i = 0; i < n_workers; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    double wall = (mono_ns() - start) / 1e9;
+
+    print_report(&totals, wall);
+    free(ranges);
+    free(workers);
+    return 0;
+}
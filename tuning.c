@@ -0,0 +1,97 @@
+// tuning.c
+#define _GNU_SOURCE   // cpu_set_t, pthread_setaffinity_np
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "tuning.h"
+
+#define PAGE_GUESS 4096   // touching every 4 KB covers every page size
+
+/**
+ * Touch kb of stack below us. noinline so the array really is below the
+ * caller's frame, volatile so the writes aren't optimized away.
+ */
+static __attribute__((noinline)) void prefault_stack(int kb)
+{
+    volatile char stack[(size_t)kb * 1024];
+    for (size_t i = 0; i < sizeof(stack); i += PAGE_GUESS)
+        stack[i] = 0;
+}
+
+static void cpu_list(uint64_t cpus, char *out, size_t cap)
+{
+    size_t n = 0;
+    out[0] = '\0';
+    for (int c = 0; c < 64 && n < cap; c++) {
+        if (!(cpus >> c & 1))
+            continue;
+        int last = c;
+        while (last < 63 && (cpus >> (last + 1) & 1))
+            last++;
+        if (last == c)
+            n += snprintf(out + n, cap - n, "%s%d", n ? "," : "", c);
+        else
+            n += snprintf(out + n, cap - n, "%s%d-%d", n ? "," : "", c, last);
+        c = last;
+    }
+}
+
+int tuning_apply(const char *who, const Tuning *t, int verbose)
+{
+    int failed = 0;
+    char done[160] = "";
+    size_t n = 0;
+
+    // Memory first: with MCL_FUTURE the stack prefaulted below stays resident
+    if (t->lock_memory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+            printf("%s ⚠️ mlockall failed: %s\n", who, strerror(errno));
+            failed++;
+        } else {
+            n += snprintf(done + n, sizeof(done) - n, ", memory locked");
+        }
+    }
+
+    if (t->prefault_stack_kb > 0) {
+        prefault_stack(t->prefault_stack_kb);
+        n += snprintf(done + n, sizeof(done) - n, ", %d KB of stack prefaulted",
+                      t->prefault_stack_kb);
+    }
+
+    if (t->cpus) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c = 0; c < 64; c++) {
+            if (t->cpus >> c & 1)
+                CPU_SET(c, &set);
+        }
+        char list[128];
+        cpu_list(t->cpus, list, sizeof(list));
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            printf("%s ⚠️ pinning to CPUs %s failed: %s\n", who, list, strerror(err));
+            failed++;
+        } else {
+            n += snprintf(done + n, sizeof(done) - n, ", CPUs %s", list);
+        }
+    }
+
+    // Last, so the setup above doesn't run ahead of everything else
+    if (t->priority > 0) {
+        struct sched_param sp = { .sched_priority = t->priority };
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+        if (err != 0) {
+            printf("%s ⚠️ SCHED_FIFO %d failed: %s\n", who, t->priority, strerror(err));
+            failed++;
+        } else {
+            n += snprintf(done + n, sizeof(done) - n, ", SCHED_FIFO %d", t->priority);
+        }
+    }
+
+    if (verbose && n > 0)
+        printf("%s Tuning: %s\n", who, done + 2);
+    return failed;
+}
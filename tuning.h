@@ -0,0 +1,24 @@
+// tuning.h
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <stdint.h>
+
+// Scheduling of the referee and the players (config keys sched_fifo,
+// referee_cpus / player_cpus, lock_memory and prefault_stack). Everything is
+// best effort: without the privilege (CAP_SYS_NICE for SCHED_FIFO,
+// CAP_IPC_LOCK or a big enough RLIMIT_MEMLOCK for mlockall) a warning is
+// printed and the game runs untuned.
+typedef struct {
+    int priority;           // SCHED_FIFO priority, 0 => leave the policy alone
+    uint64_t cpus;          // bit n => CPU n, 0 => leave the affinity alone
+    int lock_memory;        // mlockall(MCL_CURRENT | MCL_FUTURE), process-wide
+    int prefault_stack_kb;  // stack to touch now, so ticks don't fault it in
+} Tuning;
+
+// Apply t to the calling thread (and, for lock_memory, its process). who
+// prefixes the warnings; verbose also prints what took.
+// => how many of the settings asked for failed
+int tuning_apply(const char *who, const Tuning *t, int verbose);
+
+#endif